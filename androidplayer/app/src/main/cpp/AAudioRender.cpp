@@ -124,49 +124,68 @@ void AAudioRender::configure(int32_t sampleRate, int32_t channelCnt, aaudio_form
 
 // 实现回调函数
 
+// 每个音频帧的字节数 = 通道数 * 每个采样的字节数
+static int32_t bytesPerFrame(AAudioStream* stream) {
+    int32_t bytesPerSample = AAudioStream_getFormat(stream) == AAUDIO_FORMAT_PCM_FLOAT ? 4 : 2;
+    return AAudioStream_getChannelCount(stream) * bytesPerSample;
+}
 
-int AAudioRender::audioCallback(AAudioStream* stream, void* user_data, void* audio_data, int32_t num_frames) {
-    // 将用户数据转换为环形缓冲区指针
-    RingBuffer<uint8_t>* pcmBuffer = static_cast<RingBuffer<uint8_t>*>(user_data);
-    if (!pcmBuffer) {
-        LOGE("音频回调函数", "用户数据为空");
-        return 1; // 停止回调
+// 从环形缓冲区取出当前已有的数据，不足的部分补静音，不会等待解码线程
+static int fillFromRing(AAudioStream* stream, AudioPlaybackState* state, void* audio_data, int32_t num_frames) {
+    const int32_t frameBytes = bytesPerFrame(stream);
+    size_t bytesToRead = static_cast<size_t>(num_frames) * frameBytes;
+    uint8_t* out = static_cast<uint8_t*>(audio_data);
+
+    // seek 之后解码线程请求清空：跳过旧数据，音频时钟从新数据重新计算
+    if (state->ring->applyDiscard()) {
+        state->bytesConsumed.store(0, std::memory_order_relaxed);
+        state->playingSerial = state->serial.load(std::memory_order_relaxed);
     }
 
-    // 计算需要读取的字节数
-    int32_t bytesPerFrame = AAudioStream_getSamplesPerFrame(stream) * AAudioStream_getChannelCount(stream);
-    int32_t bytesToRead = num_frames * bytesPerFrame;
-
-    // 从环形缓冲区中读取数据
-    size_t bytesRead = pcmBuffer->read(static_cast<uint8_t*>(audio_data), bytesToRead);
-    LOGE("音频回调函数","到%d", bytesRead);
-    if (bytesRead != bytesToRead) {
-        LOGE("音频回调函数", "环形缓冲区数据不足，读取的字节数: %zu，需要的字节数: %d", bytesRead, bytesToRead);
-        // 可以选择继续回调或停止回调，这里选择继续回调
-        memset(static_cast<uint8_t*>(audio_data) + bytesRead, 0, bytesToRead - bytesRead); // 填充剩余部分为 0
+    // 直接从环形缓冲区的可读区域拷贝到 AAudio 的缓冲区，不经过中间内存
+    RingBuffer<uint8_t>::Region region = state->ring->beginRead(bytesToRead);
+    memcpy(out, region.first.data, region.first.size);
+    memcpy(out + region.first.size, region.second.data, region.second.size);
+    size_t bytesRead = region.total();
+    state->ring->commitRead(bytesRead);
+
+    // 更新音频时钟：本次数据之前已交给设备的位置，减去设备中还没播放的帧，就是此刻正在播放的位置
+    uint64_t consumedBefore = state->bytesConsumed.load(std::memory_order_relaxed);
+    state->bytesConsumed.store(consumedBefore + bytesRead, std::memory_order_relaxed);
+    int64_t basePtsUs = state->basePtsUs.load(std::memory_order_acquire);
+    int32_t sampleRate = AAudioStream_getSampleRate(stream);
+    if (state->clock && basePtsUs != MasterClock::kNoTime && sampleRate > 0 && bytesRead > 0) {
+        int64_t queuedFrames = AAudioStream_getFramesWritten(stream) - AAudioStream_getFramesRead(stream);
+        if (queuedFrames < 0) {
+            queuedFrames = 0;
+        }
+        int64_t playingFrame = (int64_t)(consumedBefore / frameBytes) - queuedFrames;
+        if (playingFrame < 0) {
+            playingFrame = 0;
+        }
+        state->clock->setAudioTime(basePtsUs + playingFrame * 1000000 / sampleRate, state->playingSerial);
+    }
+    if (bytesRead < bytesToRead) {
+        memset(out + bytesRead, 0, bytesToRead - bytesRead); // 填充剩余部分为 0
+        state->underruns.fetch_add(1, std::memory_order_relaxed);
+        state->silenceBytes.fetch_add(bytesToRead - bytesRead, std::memory_order_relaxed);
     }
     return 0; // 继续调用回调
 }
 
-
-int AAudioRender::myAudioCallback(AAudioStream* stream, void* userData, void* buffer, int32_t frames) {
-    // 将用户数据转换为环形缓冲区指针
-    RingBuffer<uint8_t>* pcmBuffer = static_cast<RingBuffer<uint8_t>*>(userData);
-    if (!pcmBuffer) {
-        LOGE("音频回调函数", "用户数据为空");
+int AAudioRender::audioCallback(AAudioStream* stream, void* user_data, void* audio_data, int32_t num_frames) {
+    AudioPlaybackState* state = static_cast<AudioPlaybackState*>(user_data);
+    if (!state || !state->ring) {
         return 1; // 停止回调
     }
+    return fillFromRing(stream, state, audio_data, num_frames);
+}
 
-    // 计算需要读取的字节数
-    int32_t bytesPerFrame = AAudioStream_getSamplesPerFrame(stream) * AAudioStream_getChannelCount(stream);
-    int32_t bytesToRead = frames * bytesPerFrame;
 
-    // 从环形缓冲区中读取数据
-    size_t bytesRead = pcmBuffer->read(static_cast<uint8_t*>(buffer), bytesToRead);
-    if (bytesRead != bytesToRead) {
-        LOGE("音频回调函数", "环形缓冲区数据不足，读取的字节数: %zu，需要的字节数: %d", bytesRead, bytesToRead);
-        // 可以选择继续回调或停止回调，这里选择继续回调
-        memset(static_cast<uint8_t*>(buffer) + bytesRead, 0, bytesToRead - bytesRead); // 填充剩余部分为 0
+int AAudioRender::myAudioCallback(AAudioStream* stream, void* userData, void* buffer, int32_t frames) {
+    AudioPlaybackState* state = static_cast<AudioPlaybackState*>(userData);
+    if (!state || !state->ring) {
+        return 1; // 停止回调
     }
-    return 0; // 继续调用回调
-}
\ No newline at end of file
+    return fillFromRing(stream, state, buffer, frames);
+}
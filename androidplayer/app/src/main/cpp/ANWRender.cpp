@@ -1,5 +1,4 @@
 #include "ANWRender.h"
-#include <string.h>
 #include "log.h"
 
 #define LOG_TAG "ANWDisplay"
@@ -8,31 +7,46 @@ ANWRender::ANWRender(ANativeWindow* window) {
     native_window = window;
 }
 
-int ANWRender::init(int videoWidth, int videoHeight) {
-    width = videoWidth;
-    height = videoHeight;
-    if (native_window == NULL)
-        return -1;
-    return ANativeWindow_setBuffersGeometry(native_window, videoWidth,
-                                            videoHeight, WINDOW_FORMAT_RGBA_8888);
+ANWRender::~ANWRender() {
+    sws_freeContext(sws_ctx);
 }
 
-int ANWRender::render(uint8_t* rgba) {
-    if (native_window == NULL || rgba == NULL)
-        return -1;
-
-    ANativeWindow_Buffer out_buffer;
-    ANativeWindow_lock(native_window, &out_buffer, NULL);
+bool ANWRender::init() {
+    return native_window != NULL;
+}
 
-    int srcLineSize = width * 4;
-    int dstLineSize = out_buffer.stride * 4;
-    uint8_t* dstBuffer = static_cast<uint8_t*>(out_buffer.bits);
+bool ANWRender::render(const AVFrame* frame) {
+    if (native_window == NULL || frame == NULL)
+        return false;
+
+    if (frame->width != width || frame->height != height) {
+        // 窗口缓冲区与视频同尺寸，缩放交给系统合成
+        if (ANativeWindow_setBuffersGeometry(native_window, frame->width, frame->height,
+                                             WINDOW_FORMAT_RGBA_8888) != 0) {
+            LOGE(LOG_TAG, "设置窗口缓冲区失败: %dx%d", frame->width, frame->height);
+            return false;
+        }
+        width = frame->width;
+        height = frame->height;
+    }
+    sws_ctx = sws_getCachedContext(sws_ctx, width, height, (AVPixelFormat)frame->format,
+                                   width, height, AV_PIX_FMT_RGBA,
+                                   SWS_BILINEAR, NULL, NULL, NULL);
+    if (!sws_ctx) {
+        LOGE(LOG_TAG, "创建 RGBA 转换失败");
+        return false;
+    }
 
-    for (int i = 0; i < height; ++i) {
-        memcpy(dstBuffer + i * dstLineSize, rgba + i * srcLineSize, srcLineSize);
+    ANativeWindow_Buffer out_buffer;
+    if (ANativeWindow_lock(native_window, &out_buffer, NULL) != 0) {
+        LOGE(LOG_TAG, "锁定窗口缓冲区失败");
+        return false;
     }
+    // 直接写入窗口缓冲区，不经过中间的 RGBA 缓冲
+    uint8_t* dst[4] = {static_cast<uint8_t*>(out_buffer.bits), NULL, NULL, NULL};
+    int dstLineSize[4] = {out_buffer.stride * 4, 0, 0, 0};
+    sws_scale(sws_ctx, frame->data, frame->linesize, 0, height, dst, dstLineSize);
 
     ANativeWindow_unlockAndPost(native_window);
-    return 0;
-
+    return true;
 }
@@ -1,47 +1,119 @@
 #include "CircularBuffer.h"
 
-template <typename T>
-CircularBuffer<T>::CircularBuffer(int capacity) : capacity_(capacity), readIndex_(0), writeIndex_(0) {
-    buffer_.resize(capacity);
+CircularBuffer::CircularBuffer(int capacity, std::chrono::milliseconds stallTimeout)
+        : capacity_(capacity > 0 ? capacity : 1), stallTimeout_(stallTimeout) {
+    // 多出的一个槽位留给消费者正在显示的帧
+    frames_.resize(capacity_ + 1);
+    for (AVFrame*& frame : frames_) {
+        frame = av_frame_alloc();
+    }
+    free_ = frames_;
+    buffer_.resize(capacity_);
+    consumerActive_ = Clock::now();
+}
+
+CircularBuffer::~CircularBuffer() {
+    for (AVFrame*& frame : frames_) {
+        av_frame_free(&frame);
+    }
 }
 
-template <typename T>
-void CircularBuffer<T>::write(T item) {
+bool CircularBuffer::write(AVFrame* frame) {
     std::unique_lock<std::mutex> lock(mutex_);
-    // 等待缓冲器有空间
-    while (isFull()) {
-        condNotFull_.wait(lock);
+    AVFrame* slot = nullptr;
+    while (!slot) {
+        if (finished_) {
+            return false;
+        }
+        if (!isFullLocked()) {
+            slot = free_.back();
+            free_.pop_back();
+            break;
+        }
+        // 等待消费者取走一帧；消费者长时间没有动静就覆盖最旧的帧
+        const Clock::time_point deadline = consumerActive_ + stallTimeout_;
+        if (count_ > 0 && Clock::now() >= deadline) {
+            slot = buffer_[readIndex_];
+            readIndex_ = (readIndex_ + 1) % capacity_;
+            count_--;
+            av_frame_unref(slot);
+            overwritten_++;
+            break;
+        }
+        condNotFull_.wait_until(lock, deadline);
     }
 
-    buffer_[writeIndex_] = item;
+    av_frame_move_ref(slot, frame);
+    buffer_[writeIndex_] = slot;
     writeIndex_ = (writeIndex_ + 1) % capacity_;
+    count_++;
+    written_++;
     condNotEmpty_.notify_one();
+    return true;
 }
 
-template <typename T>
-T CircularBuffer<T>::read() {
+AVFrame* CircularBuffer::read() {
     std::unique_lock<std::mutex> lock(mutex_);
     // 等待缓冲器有数据
-    while (isEmpty()) {
+    while (isEmptyLocked()) {
+        if (finished_) {
+            return nullptr;
+        }
+        consumerActive_ = Clock::now();
         condNotEmpty_.wait(lock);
     }
 
-    T item = buffer_[readIndex_];
+    AVFrame* item = buffer_[readIndex_];
     buffer_[readIndex_] = nullptr;
     readIndex_ = (readIndex_ + 1) % capacity_;
-    condNotFull_.notify_one();
+    count_--;
+    consumerActive_ = Clock::now();
     return item;
 }
 
-template <typename T>
-bool CircularBuffer<T>::isEmpty() const {
-    return readIndex_ == writeIndex_;
+void CircularBuffer::release(AVFrame* frame) {
+    if (!frame) {
+        return;
+    }
+    av_frame_unref(frame);
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(frame);
+    consumerActive_ = Clock::now();
+    condNotFull_.notify_one();
+}
+
+void CircularBuffer::keepAlive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    consumerActive_ = Clock::now();
+}
+
+void CircularBuffer::setFinished(bool finished) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = finished;
+    condNotEmpty_.notify_all();
+    condNotFull_.notify_all();
+}
+
+bool CircularBuffer::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_ && isEmptyLocked();
+}
+
+bool CircularBuffer::isEmpty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isEmptyLocked();
 }
 
-template <typename T>
-bool CircularBuffer<T>::isFull() const {
-    return (writeIndex_ + 1) % capacity_ == readIndex_;
+bool CircularBuffer::isFull() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isFullLocked();
 }
 
-// 显式实例化模板类，用于处理 AVFrame* 类型
-template class CircularBuffer<AVFrame*>;
\ No newline at end of file
+CircularBufferStats CircularBuffer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CircularBufferStats stats;
+    stats.written = written_;
+    stats.overwritten = overwritten_;
+    stats.ready = count_;
+    return stats;
+}
@@ -1,29 +1,46 @@
 #include "audiodecoder.h"
-#include <android/log.h>
+#include "log.h"
 #include <libavcodec/avcodec.h>
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 #define LOG_TAG "AudioDecoder"
-#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
-#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+namespace {
+
+// 平面格式每个声道一个数据指针，交错格式只有一个
+int inputPlanes(const AVFrame* frame) {
+    return av_sample_fmt_is_planar(static_cast<AVSampleFormat>(frame->format)) ? frame->channels : 1;
+}
+
+}  // namespace
 
 AudioDecoder::AudioDecoder(AudioProcessingContext& ctx) : ctx_(ctx) {}
 
+AudioDecoder::~AudioDecoder() {
+    swr_free(&swr_ctx_);
+}
+
 bool AudioDecoder::setupDecoder() {
     ctx_.codec = avcodec_find_decoder(ctx_.codec_par->codec_id);
     if (!ctx_.codec) {
-        LOGE("找不到解码器");
+        LOGE(LOG_TAG, "找不到解码器");
         return false;
     }
 
     ctx_.codec_ctx = avcodec_alloc_context3(ctx_.codec);
+    if (!ctx_.codec_ctx) {
+        LOGE(LOG_TAG, "无法分配解码器上下文");
+        return false;
+    }
     if (avcodec_parameters_to_context(ctx_.codec_ctx, ctx_.codec_par) < 0) {
-        LOGE("无法复制编解码参数");
+        LOGE(LOG_TAG, "无法复制编解码参数");
         return false;
     }
 
     if (avcodec_open2(ctx_.codec_ctx, ctx_.codec, nullptr) < 0) {
-        LOGE("无法打开解码器");
+        LOGE(LOG_TAG, "无法打开解码器");
         return false;
     }
 
@@ -36,97 +53,210 @@ bool AudioDecoder::setupDecoder() {
                                   ctx_.codec_ctx->sample_rate,
                                   0, nullptr);
     if (!swr_ctx_ || swr_init(swr_ctx_) < 0) {
-        LOGE("初始化音频重采样器失败");
+        LOGE(LOG_TAG, "初始化音频重采样器失败");
         return false;
     }
 
-    LOGI("解码器初始化完成 采样率: %d 通道数: %d",
+    LOGI(LOG_TAG, "解码器初始化完成 采样率: %d 通道数: %d",
          ctx_.codec_ctx->sample_rate, ctx_.codec_ctx->channels);
+    if (ctx_.startup_trace) {
+        ctx_.startup_trace->mark(StartupPhase::AudioCodecOpen);
+    }
     return true;
 }
 
-void AudioDecoder::decode(PacketQueue<AVPacket*>& packetQueue, RingBuffer<uint8_t>& ringBuffer) {
-    LOGI("开始解码音频");
+void AudioDecoder::decode(SpscQueue<AVPacket*>& packetQueue, AudioPlaybackState& playback) {
+    LOGI(LOG_TAG, "开始解码音频");
+    RingBuffer<uint8_t>& ringBuffer = *playback.ring;
     AVFrame* frame = av_frame_alloc();
-    uint8_t* convertedData = nullptr;
-    int maxOutputSamples = 0;
     int packetCount = 0;
-    LOGI("音频队列的总长度%d", packetQueue.size());
+    // 环形缓冲区里是交错的 S16 PCM，每个音频帧的字节数
+    const int bytesPerFrame = av_get_bytes_per_sample(AV_SAMPLE_FMT_S16) * ctx_.codec_ctx->channels;
+    LOGI(LOG_TAG, "音频队列的总长度%zu", packetQueue.size());
+    // 当前数据所属的序号，收到 seek 标记包时更新
+    uint32_t serial = ctx_.control ? ctx_.control->serial() : 0;
+    auto stale = [&] { return ctx_.control && ctx_.control->isStale(serial); };
 
     while (!ctx_.decoding_completed || packetQueue.size() > 0) {
-        AVPacket* pkt = packetQueue.pop();
+        // 用完后自动归还到回收池
+        PooledPacket pkt(ctx_.packet_pool, packetQueue.pop());
         if (!pkt) {
+            // 队列已结束且为空
+            break;
+        }
+
+        if (isSeekMarker(pkt.get())) {
+            serial = seekMarkerSerial(pkt.get());
+            flushForSeek(playback, serial);
+            SeekRequest request;
+            const bool accurate = ctx_.control && ctx_.control->seekFor(serial, &request) &&
+                                  request.mode == SeekMode::Accurate;
+            seekTargetUs_ = accurate ? request.targetUs : MasterClock::kNoTime;
+            continue;
+        }
+        if (stale()) {
             continue;
         }
+        // 解复用线程读到了结尾：送入空包取出解码器缓存的最后几帧，之后等待 seek 或者队列结束
+        const bool endOfStream = isEndOfStreamMarker(pkt.get());
 
         packetCount++;
-        LOGI("取出一条音频数据 (总数: %d)", packetCount);
+        LOGV(LOG_TAG, "取出一条音频数据 (总数: %d)", packetCount);
 
-        if (avcodec_send_packet(ctx_.codec_ctx, pkt) < 0) {
-            LOGE("发送 packet 到解码器失败");
-            av_packet_free(&pkt);
+        int send_ret = avcodec_send_packet(ctx_.codec_ctx, endOfStream ? nullptr : pkt.get());
+        pkt.reset();
+        if (send_ret < 0) {
+            LOGE(LOG_TAG, "发送 packet 到解码器失败");
+            if (endOfStream) {
+                finishStream(playback, serial);
+            }
             continue;
         }
-        av_packet_free(&pkt);
 
         while (true) {
             int ret = avcodec_receive_frame(ctx_.codec_ctx, frame);
             if (ret == AVERROR(EAGAIN)) {
                 break;
             } else if (ret == AVERROR_EOF) {
-                LOGI("解码完成");
-                ctx_.decoding_completed = true;
+                // 结束标记送入的空包已经排空
                 break;
             } else if (ret < 0) {
-                LOGE("解码帧出错");
+                LOGE(LOG_TAG, "解码帧出错");
                 break;
             }
 
-            if (frame->nb_samples > maxOutputSamples) {
-                maxOutputSamples = frame->nb_samples;
-                if (convertedData) {
-                    av_freep(&convertedData);
-                }
+            if (swr_ctx_ == nullptr) {
+                LOGE(LOG_TAG, "重采样上下文未初始化");
+                break;
+            }
+            if (stale()) {
+                av_frame_unref(frame);
+                continue;
+            }
+
+            // 本帧的起始时间和要送进重采样器的输入，精确 seek 时从目标位置开始
+            int64_t ptsUs = frame->best_effort_timestamp;
+            ptsUs = ptsUs == AV_NOPTS_VALUE ? 0 : av_rescale_q(ptsUs, ctx_.time_base, AV_TIME_BASE_Q);
+            int inputSamples = frame->nb_samples;
+            input_.assign(frame->extended_data, frame->extended_data + inputPlanes(frame));
+            if (seekTargetUs_ != MasterClock::kNoTime && !trimToSeekTarget(frame, &inputSamples, &ptsUs)) {
+                av_frame_unref(frame);
+                continue;
+            }
 
-                ret = av_samples_alloc(&convertedData, nullptr,
-                                       ctx_.codec_ctx->channels,
-                                       maxOutputSamples,
-                                       AV_SAMPLE_FMT_S16, 0);
-                if (ret < 0) {
-                    LOGE("av_samples_alloc 分配内存失败");
+            // 等待环形缓冲区腾出足够空间，然后让 swr_convert 直接写进缓冲区，不经过中间内存。
+            // 等待期间有新的 seek 请求时，这一帧已经过期，不再等待
+            int maxOutputSamples = swr_get_out_samples(swr_ctx_, inputSamples);
+            size_t needed = static_cast<size_t>(maxOutputSamples) * bytesPerFrame;
+            if (!ringBuffer.waitForWrite(needed, stale)) {
+                av_frame_unref(frame);
+                if (stale()) {
                     continue;
                 }
+                LOGI(LOG_TAG, "环形缓冲区已关闭，丢弃剩余音频");
+                break;
             }
 
-            if (swr_ctx_ == nullptr) {
-                LOGE("重采样上下文未初始化");
-                break;
+            // 第一次写入前记录起始 pts，之后音频时钟 = 起始 pts + 已播放的采样数
+            if (playback.basePtsUs.load(std::memory_order_relaxed) == MasterClock::kNoTime) {
+                playback.basePtsUs.store(ptsUs, std::memory_order_release);
             }
 
-            int convertedSamples = swr_convert(swr_ctx_, &convertedData, maxOutputSamples,
-                                               (const uint8_t**)frame->data, frame->nb_samples);
+            RingBuffer<uint8_t>::Region region = ringBuffer.beginWrite(needed);
+            // 缓冲区按当前声道数的整帧分配（见 native-lib），所以回绕点总落在帧边界上
+            uint8_t* out = region.first.data;
+            int firstSamples = static_cast<int>(region.first.size / bytesPerFrame);
+            int convertedSamples = swr_convert(swr_ctx_, &out, firstSamples, input_.data(), inputSamples);
             if (convertedSamples < 0) {
-                LOGE("重采样失败");
+                LOGE(LOG_TAG, "重采样失败");
+                av_frame_unref(frame);
                 continue;
             }
-
-            int dataSize = av_get_bytes_per_sample(AV_SAMPLE_FMT_S16) *
-                           convertedSamples * ctx_.codec_ctx->channels;
-
-            size_t bytesWritten = ringBuffer.write(convertedData, dataSize);
-            LOGI("缓冲区写入数据+1");
-            if (bytesWritten != dataSize) {
-                LOGI("环形缓冲区写入: %zu/%d 字节 (缓冲区可能已满)", bytesWritten, dataSize);
+            if (convertedSamples == firstSamples && region.second.size > 0) {
+                // 第一段写满了，剩余输出由 swr 内部缓存，继续写到回绕后的第二段。
+                // 输入输出采样率相同，这里传空输入只会取出缓存的样本
+                uint8_t* out2 = region.second.data;
+                int moreSamples = swr_convert(swr_ctx_, &out2,
+                                              static_cast<int>(region.second.size / bytesPerFrame),
+                                              nullptr, 0);
+                if (moreSamples > 0) {
+                    convertedSamples += moreSamples;
+                }
             }
+
+            ringBuffer.commitWrite(static_cast<size_t>(convertedSamples) * bytesPerFrame);
+            LOGV(LOG_TAG, "缓冲区写入数据+1");
+            av_frame_unref(frame);
+        }
+        if (endOfStream) {
+            finishStream(playback, serial);
         }
     }
 
-    LOGI("解码音频完成, 共处理 %d 个包", packetCount);
+    LOGI(LOG_TAG, "解码音频完成, 共处理 %d 个包", packetCount);
 
-    if (convertedData) {
-        av_freep(&convertedData);
-    }
     av_frame_free(&frame);
     swr_free(&swr_ctx_);
     ctx_.decoding_completed = true;
-}
\ No newline at end of file
+    if (ctx_.control) {
+        ctx_.control->onStageStopped(PlaybackStage::Audio);
+    }
+}
+
+// 解码器已经排空：清空后才能接收 seek 之后的数据，等回调播完环形缓冲区里剩下的采样再报告到结尾。
+// 期间有新的 seek 或者音频输出已经关闭时不再等待
+void AudioDecoder::finishStream(AudioPlaybackState& playback, uint32_t serial) {
+    avcodec_flush_buffers(ctx_.codec_ctx);
+    RingBuffer<uint8_t>& ringBuffer = *playback.ring;
+    while (!ringBuffer.isEmpty() && !ringBuffer.isClosed() &&
+           !(ctx_.control && ctx_.control->isStale(serial))) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kDrainPollMs));
+    }
+    if (ctx_.control) {
+        ctx_.control->onEndOfStream(PlaybackStage::Audio, serial);
+    }
+    LOGI(LOG_TAG, "音频解码到结尾 (#%u)", serial);
+}
+
+// seek 之后：清空解码器和重采样器，让回调丢掉环形缓冲区里的旧数据。
+// 等回调执行完丢弃再写新数据，新的起始 pts 与回调计数的清零就不会错开
+void AudioDecoder::flushForSeek(AudioPlaybackState& playback, uint32_t serial) {
+    avcodec_flush_buffers(ctx_.codec_ctx);
+    if (swr_ctx_ && swr_init(swr_ctx_) < 0) {
+        LOGE(LOG_TAG, "重置音频重采样器失败");
+    }
+    playback.basePtsUs.store(MasterClock::kNoTime, std::memory_order_relaxed);
+    playback.serial.store(serial, std::memory_order_relaxed);
+    playback.ring->requestDiscard();
+    if (!playback.ring->waitForDiscard(kDiscardTimeoutMs)) {
+        LOGW(LOG_TAG, "seek #%u: 音频回调没有及时清空缓冲区", serial);
+    }
+    LOGD(LOG_TAG, "seek #%u: 清空音频解码器", serial);
+}
+
+bool AudioDecoder::trimToSeekTarget(const AVFrame* frame, int* samples, int64_t* ptsUs) {
+    if (frame->sample_rate <= 0) {
+        seekTargetUs_ = MasterClock::kNoTime;
+        return true;
+    }
+    const int64_t skip = av_rescale(seekTargetUs_ - *ptsUs, frame->sample_rate, AV_TIME_BASE);
+    if (skip >= *samples) {
+        return false;
+    }
+    seekTargetUs_ = MasterClock::kNoTime;
+    if (skip <= 0) {
+        return true;
+    }
+    // 不拷贝数据，直接把输入指针移到目标采样处
+    const AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+    const int bytesPerSample = av_get_bytes_per_sample(format);
+    const size_t offset = static_cast<size_t>(skip) * bytesPerSample *
+                          (av_sample_fmt_is_planar(format) ? 1 : frame->channels);
+    for (const uint8_t*& plane : input_) {
+        plane += offset;
+    }
+    *samples -= static_cast<int>(skip);
+    *ptsUs += av_rescale(skip, AV_TIME_BASE, frame->sample_rate);
+    LOGD(LOG_TAG, "精确 seek: 裁掉 %lld 个采样", (long long)skip);
+    return true;
+}
@@ -0,0 +1,132 @@
+// 解复用基准：对同一个本地文件，比较 libavformat 默认的 file 协议、MappedFileIO（mmap）和
+// ReadAheadFileIO（后台预读）读完所有 AVPacket 的耗时和 read 类系统调用次数（来自 /proc/self/io 的 syscr）。
+// 后台预读的系统调用发生在读线程上，另外统计解复用线程等待存储的次数（stalls）。
+// 多跑几轮让文件进入页缓存，比较的是 IO 路径本身的开销而不是存储速度。
+// 用法: demux_bench <文件路径> [轮数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include "fileio.h"
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+struct DemuxResult {
+    bool ok = false;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+    uint64_t syscalls = 0;
+    uint64_t stalls = 0;
+};
+
+// /proc/self/io 中的 syscr：进程累计的 read 类系统调用次数
+static uint64_t readSyscalls() {
+    FILE* file = std::fopen("/proc/self/io", "r");
+    if (!file) {
+        return 0;
+    }
+    char line[128];
+    uint64_t value = 0;
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, "syscr:", 6) == 0) {
+            value = std::strtoull(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+static const char* modeName(FileIOMode mode) {
+    switch (mode) {
+        case FileIOMode::Mapped:
+            return "mmap";
+        case FileIOMode::ReadAhead:
+            return "readahead";
+        default:
+            return "default";
+    }
+}
+
+static DemuxResult runOnce(const char* path, FileIOMode mode) {
+    DemuxResult result;
+    const uint64_t syscallsBefore = readSyscalls();
+    auto begin = std::chrono::steady_clock::now();
+
+    AVFormatContext* fmt = avformat_alloc_context();
+    std::unique_ptr<FileIO> io = FileIO::create(mode);
+    if (io) {
+        if (!io->open(path)) {
+            avformat_free_context(fmt);
+            return result;
+        }
+        fmt->pb = io->context();
+        fmt->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    if (avformat_open_input(&fmt, path, nullptr, nullptr) != 0) {
+        return result;
+    }
+    if (avformat_find_stream_info(fmt, nullptr) < 0) {
+        avformat_close_input(&fmt);
+        return result;
+    }
+    if (io && fmt->bit_rate > 0) {
+        io->setBitrate(fmt->bit_rate);
+    }
+
+    AVPacket* pkt = av_packet_alloc();
+    while (av_read_frame(fmt, pkt) >= 0) {
+        result.packets++;
+        result.bytes += pkt->size;
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+    if (io) {
+        result.stalls = io->stats().stalls;
+        io->close();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    // 减去读取 /proc/self/io 自身的一次 read
+    const uint64_t syscallsAfter = readSyscalls();
+    result.syscalls = syscallsAfter > syscallsBefore + 1 ? syscallsAfter - syscallsBefore - 1 : 0;
+    result.ok = true;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "用法: %s <文件路径> [轮数]\n", argv[0]);
+        return 1;
+    }
+    const char* path = argv[1];
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    av_log_set_level(AV_LOG_ERROR);
+
+    // 预热页缓存
+    runOnce(path, FileIOMode::Default);
+
+    std::printf("%-10s %-6s %10s %12s %10s %12s %10s %8s\n",
+                "io", "round", "packets", "MB", "seconds", "MB/s", "syscr", "stalls");
+    for (FileIOMode mode : {FileIOMode::Default, FileIOMode::Mapped, FileIOMode::ReadAhead}) {
+        const char* name = modeName(mode);
+        for (int i = 0; i < rounds; i++) {
+            DemuxResult r = runOnce(path, mode);
+            if (!r.ok) {
+                std::fprintf(stderr, "%s: 打开或解复用失败\n", name);
+                return 1;
+            }
+            const double mb = r.bytes / (1024.0 * 1024.0);
+            std::printf("%-10s %-6d %10llu %12.1f %10.4f %12.1f %10llu %8llu\n",
+                        name, i, (unsigned long long)r.packets, mb, r.seconds,
+                        mb / r.seconds, (unsigned long long)r.syscalls, (unsigned long long)r.stalls);
+        }
+    }
+    return 0;
+}
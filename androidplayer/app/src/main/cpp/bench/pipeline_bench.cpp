@@ -0,0 +1,75 @@
+// 完整管线基准：解复用 -> 视频解码 -> 显示信箱 -> VideoRender -> NullVideoSink，不需要窗口和 GPU。
+// 不设主时钟，渲染线程拿到帧就交给后端，测得的是管线能达到的最大帧率。
+// 默认对输出的可见像素计算 Adler-32，改动解码或转换路径前后对比校验和，可以确认输出的画面没有变化；
+// 只比较吞吐时加 --no-checksum 去掉校验的开销。
+// 用法: pipeline_bench <文件路径> [--no-checksum]
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "audioContext.h"
+#include "context.h"
+#include "demuxer.h"
+#include "nullvideosink.h"
+#include "packetpool.h"
+#include "videodecoder.h"
+#include "videorender.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "用法: %s <文件路径> [--no-checksum]\n", argv[0]);
+        return 1;
+    }
+    const bool checksum = !(argc > 2 && std::strcmp(argv[2], "--no-checksum") == 0);
+
+    VideoProcessingContext ctx;
+    AudioProcessingContext audioctx;
+    PacketPool packetPool;
+    ctx.packet_pool = &packetPool;
+    audioctx.packet_pool = &packetPool;
+
+    Demuxer demuxer(ctx, audioctx);
+    if (!demuxer.openInput(argv[1])) {
+        std::fprintf(stderr, "打开 %s 失败\n", argv[1]);
+        return 1;
+    }
+    VideoDecoder decoder(ctx);
+    if (!decoder.setupDecoder()) {
+        std::fprintf(stderr, "解码器初始化失败\n");
+        return 1;
+    }
+
+    QueueLimits limits;
+    limits.maxPackets = 600;
+    limits.maxBytes = 32 * 1024 * 1024;
+    limits.maxDurationUs = 5 * AV_TIME_BASE;
+    SpscQueue<AVPacket*> packetQueue(1024, limits);
+    CircularBuffer frameQueue(4);
+
+    NullVideoSink sink(checksum);
+    VideoRender videoRender(frameQueue);
+    videoRender.setTimeBase(ctx.format_ctx->streams[ctx.video_stream_idx]->time_base);
+    videoRender.setSink(&sink);
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::thread demuxThread([&] { demuxer.start(packetQueue); });
+    std::thread renderThread([&] { videoRender.RenderLoop(); });
+    std::thread decodeThread([&] { decoder.decode(packetQueue, frameQueue); });
+    demuxThread.join();
+    decodeThread.join();
+    renderThread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    VideoRenderStats renderStats = videoRender.stats();
+    CircularBufferStats mailboxStats = frameQueue.stats();
+    std::printf("后端 %s: %llu 帧, %.2f 秒, %.1f fps, %.1f MB/s\n", sink.name(),
+                (unsigned long long)sink.frames(), seconds,
+                seconds > 0 ? sink.frames() / seconds : 0.0,
+                seconds > 0 ? sink.bytes() / seconds / (1024.0 * 1024.0) : 0.0);
+    std::printf("丢弃 %llu 帧, 信箱覆盖 %llu 帧\n",
+                (unsigned long long)renderStats.dropped, (unsigned long long)mailboxStats.overwritten);
+    if (checksum) {
+        std::printf("adler32 %08x\n", sink.checksum());
+    }
+    return 0;
+}
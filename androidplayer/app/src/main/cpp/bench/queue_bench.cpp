@@ -0,0 +1,60 @@
+// 队列竞争基准：一个生产者线程、一个消费者线程，在同样的容量下
+// 比较 PacketQueue（mutex + condition_variable）和 SpscQueue（无锁）的吞吐量。
+// PacketQueue 每次 push/pop 都有一条 VERBOSE 日志，默认的日志级别在编译时去掉它，测的才是队列本身；
+// 用 -DPLAYER_LOG_LEVEL=2 编译时结果主要是日志的开销。日志分级之前（每次都调用 __android_log_print）的数据不可比。
+// 用法: queue_bench [每轮元素个数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "queue.h"
+#include "SpscQueue.h"
+
+static const size_t kPacketCount = 256;
+
+template <typename Queue>
+static double runOnce(Queue& queue, std::vector<AVPacket>& packets, size_t items) {
+    auto begin = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        for (size_t i = 0; i < items; i++) {
+            queue.push(&packets[i % packets.size()]);
+        }
+        queue.setFinished(true);
+    });
+    size_t received = 0;
+    while (queue.pop() != nullptr) {
+        received++;
+    }
+    producer.join();
+    auto end = std::chrono::steady_clock::now();
+    if (received != items) {
+        std::fprintf(stderr, "丢失元素: %zu/%zu\n", received, items);
+    }
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argc, char** argv) {
+    size_t items = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::vector<AVPacket> packets(kPacketCount);
+    for (auto& pkt : packets) {
+        pkt.size = 4096;
+    }
+
+    std::printf("%-12s %-10s %12s %14s\n", "queue", "capacity", "seconds", "ops/s");
+    for (size_t capacity : {8, 64, 1024}) {
+        QueueLimits limits;
+        limits.maxPackets = capacity;
+
+        PacketQueue<AVPacket*> locked(limits);
+        double lockedSeconds = runOnce(locked, packets, items);
+        std::printf("%-12s %-10zu %12.3f %14.0f\n", "PacketQueue", capacity,
+                    lockedSeconds, items / lockedSeconds);
+
+        SpscQueue<AVPacket*> lockFree(capacity);
+        double spscSeconds = runOnce(lockFree, packets, items);
+        std::printf("%-12s %-10zu %12.3f %14.0f\n", "SpscQueue", capacity,
+                    spscSeconds, items / spscSeconds);
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+// 纹理上传基准：在 Linux 上用 Mesa 的软件 EGL（llvmpipe）创建离屏 GLES 上下文，比较 YUV420P 帧的几种上传方式：
+//   teximage   每帧对三个平面调用 glTexImage2D（改动之前的做法），紧密排列的帧
+//   subimage   YuvTextureUploader：常驻纹理 + glTexSubImage2D，紧密排列的帧
+//   rowlength  带行填充的帧，GL_UNPACK_ROW_LENGTH 一次上传（需要 ES3 或 GL_EXT_unpack_subimage）
+//   rowwise    带行填充的帧，逐行 glTexSubImage2D（ES2 的退路）
+//   repack     带行填充的帧，先在 CPU 上拷贝成紧密排列再上传
+//   pbo        带行填充的帧，PBO 轮流映射写入后由 GPU 异步更新纹理（需要 ES3）
+// call 为渲染线程阻塞在上传调用里的时间，total 为所有帧上传完成（最后 glFinish）的平均耗时。
+// 两帧数据交替使用，避免驱动跳过相同的数据。
+// 运行: EGL_PLATFORM=surfaceless LIBGL_ALWAYS_SOFTWARE=1 ./upload_bench [宽 高 帧数]
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "yuvuploader.h"
+
+namespace {
+
+// 行填充：每行多出的字节数，模拟解码器按宏块和 SIMD 对齐分配的缓冲区
+constexpr int kRowPadding = 64;
+
+struct PlaneBuffers {
+    std::vector<uint8_t> planes[3];
+    AVFrame frame;
+};
+
+void makeFrame(PlaneBuffers& buffers, int width, int height, int padding, uint8_t seed) {
+    std::memset(&buffers.frame, 0, sizeof(buffers.frame));
+    buffers.frame.format = AV_PIX_FMT_YUV420P;
+    buffers.frame.width = width;
+    buffers.frame.height = height;
+    for (int i = 0; i < 3; i++) {
+        const int planeWidth = i ? (width + 1) / 2 : width;
+        const int planeHeight = i ? (height + 1) / 2 : height;
+        const int linesize = planeWidth + padding;
+        buffers.planes[i].resize((size_t)linesize * planeHeight);
+        for (size_t j = 0; j < buffers.planes[i].size(); j++) {
+            buffers.planes[i][j] = (uint8_t)(j * 7 + seed + i);
+        }
+        buffers.frame.data[i] = buffers.planes[i].data();
+        buffers.frame.linesize[i] = linesize;
+    }
+}
+
+class OffscreenContext {
+public:
+    bool init() {
+        display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, nullptr, nullptr)) {
+            std::fprintf(stderr, "EGL 初始化失败\n");
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_ES_API);
+        // 优先 ES3，与设备上的情况一致；ES3 上下文要用带 EGL_OPENGL_ES3_BIT_KHR 的配置，不支持时退回 ES2
+        EGLConfig config = nullptr;
+        for (EGLint version : {3, 2}) {
+            const EGLint configAttribs[] = {
+                    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                    EGL_RENDERABLE_TYPE, version == 3 ? EGL_OPENGL_ES3_BIT_KHR : EGL_OPENGL_ES2_BIT,
+                    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+                    EGL_NONE
+            };
+            EGLint numConfigs = 0;
+            if (!eglChooseConfig(display_, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+                continue;
+            }
+            const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, version, EGL_NONE};
+            context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, contextAttribs);
+            if (context_ != EGL_NO_CONTEXT) {
+                break;
+            }
+        }
+        if (context_ == EGL_NO_CONTEXT) {
+            std::fprintf(stderr, "找不到可用的 EGL 配置\n");
+            return false;
+        }
+        const EGLint surfaceAttribs[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+        surface_ = eglCreatePbufferSurface(display_, config, surfaceAttribs);
+        if (surface_ == EGL_NO_SURFACE || context_ == EGL_NO_CONTEXT ||
+            !eglMakeCurrent(display_, surface_, surface_, context_)) {
+            std::fprintf(stderr, "创建 GLES 上下文失败: 0x%x\n", eglGetError());
+            return false;
+        }
+        return true;
+    }
+
+    ~OffscreenContext() {
+        if (display_ != EGL_NO_DISPLAY) {
+            eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context_ != EGL_NO_CONTEXT) {
+                eglDestroyContext(display_, context_);
+            }
+            if (surface_ != EGL_NO_SURFACE) {
+                eglDestroySurface(display_, surface_);
+            }
+            eglTerminate(display_);
+        }
+    }
+
+private:
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    EGLContext context_ = EGL_NO_CONTEXT;
+};
+
+struct RunResult {
+    double callSeconds = 0;
+    double totalSeconds = 0;
+};
+
+void report(const char* name, int frames, size_t frameBytes, const RunResult& result) {
+    std::printf("%-10s %10.3f %10.3f %12.1f\n", name, result.callSeconds * 1000.0 / frames,
+                result.totalSeconds * 1000.0 / frames,
+                frames * (double)frameBytes / result.totalSeconds / (1024.0 * 1024.0));
+}
+
+RunResult run(int frames, const std::function<void(int)>& uploadFrame) {
+    using Clock = std::chrono::steady_clock;
+    // 第一帧包含纹理分配，不计入
+    uploadFrame(0);
+    glFinish();
+    RunResult result;
+    const Clock::time_point begin = Clock::now();
+    for (int i = 1; i <= frames; i++) {
+        const Clock::time_point callBegin = Clock::now();
+        uploadFrame(i);
+        result.callSeconds += std::chrono::duration<double>(Clock::now() - callBegin).count();
+        // 每帧提交一次，相当于渲染循环里的 eglSwapBuffers
+        glFlush();
+    }
+    glFinish();
+    result.totalSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int frames = argc > 3 ? std::atoi(argv[3]) : 200;
+    if (width <= 0 || height <= 0 || frames <= 0) {
+        std::fprintf(stderr, "用法: %s [宽 高 帧数]\n", argv[0]);
+        return 1;
+    }
+
+    OffscreenContext context;
+    if (!context.init()) {
+        return 1;
+    }
+    std::printf("GL_VERSION: %s\nGL_RENDERER: %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+
+    PlaneBuffers tight[2];
+    PlaneBuffers padded[2];
+    for (int i = 0; i < 2; i++) {
+        makeFrame(tight[i], width, height, 0, (uint8_t)(i * 31));
+        makeFrame(padded[i], width, height, kRowPadding, (uint8_t)(i * 31));
+    }
+    const size_t frameBytes = (size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    std::printf("%dx%d, %d 帧, 行填充 %d 字节\n", width, height, frames, kRowPadding);
+    std::printf("%-10s %10s %10s %12s\n", "mode", "call ms", "total ms", "MB/s");
+
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    RunResult result = run(frames, [&](int n) {
+        const AVFrame& frame = tight[n & 1].frame;
+        for (int i = 0; i < 3; i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, i ? (width + 1) / 2 : width, i ? (height + 1) / 2 : height,
+                         0, GL_LUMINANCE, GL_UNSIGNED_BYTE, frame.data[i]);
+        }
+    });
+    report("teximage", frames, frameBytes, result);
+    glDeleteTextures(3, textures);
+
+    YuvTextureUploader uploader;
+    if (!uploader.init()) {
+        return 1;
+    }
+    result = run(frames, [&](int n) { uploader.upload(&tight[n & 1].frame); });
+    report("subimage", frames, frameBytes, result);
+
+    if (uploader.rowLengthSupported()) {
+        result = run(frames, [&](int n) { uploader.upload(&padded[n & 1].frame); });
+        report("rowlength", frames, frameBytes, result);
+    } else {
+        std::printf("%-10s 上下文不支持 GL_UNPACK_ROW_LENGTH\n", "rowlength");
+    }
+
+    uploader.setRowLengthEnabled(false);
+    result = run(frames, [&](int n) { uploader.upload(&padded[n & 1].frame); });
+    report("rowwise", frames, frameBytes, result);
+
+    PlaneBuffers repacked;
+    makeFrame(repacked, width, height, 0, 0);
+    result = run(frames, [&](int n) {
+        const AVFrame& src = padded[n & 1].frame;
+        for (int i = 0; i < 3; i++) {
+            const int planeWidth = i ? (width + 1) / 2 : width;
+            const int planeHeight = i ? (height + 1) / 2 : height;
+            for (int y = 0; y < planeHeight; y++) {
+                std::memcpy(repacked.frame.data[i] + (size_t)y * planeWidth,
+                            src.data[i] + (size_t)y * src.linesize[i], planeWidth);
+            }
+        }
+        uploader.upload(&repacked.frame);
+    });
+    report("repack", frames, frameBytes, result);
+    uploader.release();
+
+    YuvTextureUploader pboUploader;
+    if (!pboUploader.init(YuvUploadMode::Pbo)) {
+        return 1;
+    }
+    if (pboUploader.mode() == YuvUploadMode::Pbo) {
+        result = run(frames, [&](int n) { pboUploader.upload(&padded[n & 1].frame); });
+        report("pbo", frames, frameBytes, result);
+        std::printf("pbo: 等待 fence %llu 次\n", (unsigned long long)pboUploader.stats().fenceWaits);
+    } else {
+        std::printf("%-10s 上下文不是 ES3\n", "pbo");
+    }
+    pboUploader.release();
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "decoderthreading.h"
+#include <unistd.h>
+#include <algorithm>
+
+// 不同分辨率下线程数的上限，超过之后线程切换和帧延迟的代价大于收益
+static int threadBudgetForResolution(int width, int height) {
+    int64_t pixels = (int64_t)width * height;
+    if (pixels <= 640 * 480) {
+        return 2;
+    } else if (pixels <= 1280 * 720) {
+        return 4;
+    } else if (pixels <= 1920 * 1088) {
+        return 6;
+    }
+    return 8;
+}
+
+DecoderThreading chooseDecoderThreading(const AVCodec* codec, int width, int height) {
+    DecoderThreading threading;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threading.onlineCores = cores > 0 ? (int)cores : 1;
+    if (!codec) {
+        return threading;
+    }
+
+    if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+        threading.threadType = FF_THREAD_FRAME;
+    } else if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+        threading.threadType = FF_THREAD_SLICE;
+    } else {
+        return threading;
+    }
+
+    int usableCores = threading.onlineCores > 2 ? threading.onlineCores - 1 : threading.onlineCores;
+    threading.threadCount = std::max(1, std::min(usableCores, threadBudgetForResolution(width, height)));
+    if (threading.threadCount == 1) {
+        threading.threadType = 0;
+    }
+    return threading;
+}
+
+void applyDecoderThreading(AVCodecContext* codecCtx, const DecoderThreading& threading) {
+    codecCtx->thread_count = threading.threadCount;
+    codecCtx->thread_type = threading.threadType;
+}
+
+const char* decoderThreadTypeName(int threadType) {
+    if (threadType & FF_THREAD_FRAME) {
+        return "frame";
+    } else if (threadType & FF_THREAD_SLICE) {
+        return "slice";
+    }
+    return "none";
+}
@@ -1,83 +1,133 @@
 #include "demuxer.h"
-#include <android/log.h>
+#include "log.h"
+#include "probecache.h"
 #define TAG "Demuxer"
 #include <chrono>
 #include <thread>
 Demuxer::Demuxer(VideoProcessingContext& ctx, AudioProcessingContext& audioctx)
         : ctx_(ctx), audio_ctx_(audioctx) {}
 
-bool Demuxer::openInput(const char* url) {
-    if (avformat_open_input(&ctx_.format_ctx, url, nullptr, nullptr) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "无法打开输入文件");
-        return false;
-    }
+void Demuxer::setFileIOMode(FileIOMode mode) {
+    fileIOMode_ = mode;
+}
 
-    if (avformat_find_stream_info(ctx_.format_ctx, nullptr) < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "无法获取流信息");
-        return false;
+bool Demuxer::openFormat(const char* url, const AVInputFormat* format) {
+    if (!ctx_.format_ctx) {
+        // 上一次 avformat_open_input 失败时会释放 format_ctx
+        ctx_.format_ctx = avformat_alloc_context();
+        if (!ctx_.format_ctx) {
+            return false;
+        }
+        if (ctx_.file_io) {
+            avio_seek(ctx_.file_io->context(), 0, SEEK_SET);
+            ctx_.format_ctx->pb = ctx_.file_io->context();
+            ctx_.format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
     }
+    // ffmpeg 4.x 的 avformat_open_input 接受非 const 的 AVInputFormat
+    return avformat_open_input(&ctx_.format_ctx, url, const_cast<AVInputFormat*>(format), nullptr) == 0;
+}
 
-    // 查找视频流
-    for (unsigned i = 0; i < ctx_.format_ctx->nb_streams; i++) {
-        if (ctx_.format_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-            ctx_.video_stream_idx = i;
-            ctx_.codec_par = ctx_.format_ctx->streams[i]->codecpar;
-
-            // 查找视频解码器
-            ctx_.codec = avcodec_find_decoder(ctx_.codec_par->codec_id);
-            if (!ctx_.codec) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "未找到视频解码器");
-                return false;
-            }
-
-            // 分配解码器上下文
-            ctx_.codec_ctx = avcodec_alloc_context3(ctx_.codec);
-            if (!ctx_.codec_ctx) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "无法分配视频解码器上下文");
-                return false;
-            }
+bool Demuxer::openInput(const char* url) {
+    // 本地文件走自定义 IO：后台预读让解复用线程不直接等存储，mmap 减少 read() 系统调用和拷贝
+    const char* path = FileIO::localPath(url);
+    std::unique_ptr<FileIO> io = path ? FileIO::create(fileIOMode_) : nullptr;
+    if (io) {
+        if (io->open(path)) {
+            ctx_.format_ctx->pb = io->context();
+            ctx_.format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+            ctx_.file_io = std::move(io);
+        }
+    }
 
-            // 从编解码器参数复制到解码器上下文
-            if (avcodec_parameters_to_context(ctx_.codec_ctx, ctx_.codec_par) < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "无法复制视频编解码器参数到上下文");
-                avcodec_free_context(&ctx_.codec_ctx);
-                return false;
-            }
+    // 有探测缓存时直接指定容器格式，只读很少的数据，然后把缓存的编解码参数写回各路流
+    ProbeCache probeCache(ProbeCache::directory());
+    ProbeCacheEntry cached;
+    const bool cacheHit = path && probeCache.lookup(path, &cached);
+    const AVInputFormat* cachedFormat = cacheHit ? av_find_input_format(cached.formatName.c_str()) : nullptr;
+    if (cachedFormat) {
+        ctx_.format_ctx->probesize = ProbeCache::kCachedProbeSize;
+        ctx_.format_ctx->max_analyze_duration = ProbeCache::kCachedAnalyzeDurationUs;
+    }
 
-            // 打开解码器
-            if (avcodec_open2(ctx_.codec_ctx, ctx_.codec, nullptr) < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "无法打开视频解码器");
-                avcodec_free_context(&ctx_.codec_ctx);
-                return false;
-            }
+    bool opened = openFormat(url, cachedFormat);
+    if (!opened && cachedFormat) {
+        LOGW(TAG, "按缓存的格式 %s 打开失败，重新探测", cached.formatName.c_str());
+        cachedFormat = nullptr;
+        opened = openFormat(url, nullptr);
+    }
+    if (!opened) {
+        LOGE(TAG, "无法打开输入文件");
+        return false;
+    }
+    markPhase(StartupPhase::Open);
 
-            __android_log_print(ANDROID_LOG_INFO, TAG, "找到视频流索引: %d", i);
-            break;
+    bool restored = cachedFormat && ProbeCache::restore(cached, ctx_.format_ctx);
+    if (cachedFormat && !restored) {
+        LOGW(TAG, "探测缓存与文件不一致，完整探测");
+    }
+    if (!restored) {
+        // 恢复默认的探测量
+        ctx_.format_ctx->probesize = 5000000;
+        ctx_.format_ctx->max_analyze_duration = 0;
+    }
 
-        }
+    if (avformat_find_stream_info(ctx_.format_ctx, nullptr) < 0) {
+        LOGE(TAG, "无法获取流信息");
+        return false;
+    }
+    markPhase(StartupPhase::Probe);
+    if (restored) {
+        LOGI(TAG, "使用探测缓存打开 %s", path);
+    } else if (path) {
+        probeCache.store(path, ctx_.format_ctx);
+    }
+    // 知道码率后按固定的预读时长调整预读窗口
+    if (ctx_.file_io && ctx_.format_ctx->bit_rate > 0) {
+        ctx_.file_io->setBitrate(ctx_.format_ctx->bit_rate);
     }
 
-    if (ctx_.video_stream_idx == -1) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "未找到视频流");
+    // 这里只选择流，解码器由 VideoDecoder / AudioDecoder 各自打开，且只打开一次。
+    // 只打开视频时音频流也被丢弃，直到 openInputWithAudio 选中音频流
+    if (!selectStream(AVMEDIA_TYPE_VIDEO)) {
+        LOGE(TAG, "未找到视频流");
         return false;
     }
+    keyframes_.importFromStream(ctx_.format_ctx->streams[ctx_.video_stream_idx]);
+    LOGI(TAG, "关键帧索引: %zu 个%s", keyframes_.size(),
+         keyframes_.hasContainerIndex() ? "（容器索引）" : "，解复用时补充");
 
     return true;
 }
 
-void Demuxer::start(PacketQueue<AVPacket*>& packetQueue) {
+void Demuxer::start(SpscQueue<AVPacket*>& packetQueue) {
+    packetQueue.setTimeBase(ctx_.format_ctx->streams[ctx_.video_stream_idx]->time_base);
     AVPacket* pkt = av_packet_alloc();
     while (!ctx_.demuxing_completed) {
+        serviceSeek(packetQueue, nullptr);
+        if (holdAfterPreview()) {
+            continue;
+        }
         if (av_read_frame(ctx_.format_ctx, pkt) < 0) {
-            __android_log_print(ANDROID_LOG_INFO, TAG, "解复用视频完成");
+            if (!finishAtEnd(packetQueue, nullptr)) {
+                continue;
+            }
+            LOGI(TAG, "解复用视频完成");
             break;
         }
-        __android_log_print(ANDROID_LOG_INFO, TAG, "添加一条消息");
+        LOGV(TAG, "添加一条消息");
         if (pkt->stream_index == ctx_.video_stream_idx) {
-            AVPacket* cloned = av_packet_clone(pkt);
-            packetQueue.push(cloned);
+            keyframes_.addPacket(pkt);
+            if (acceptPacket(pkt)) {
+                pushPacket(pkt, packetQueue);
+            }
         }
         av_packet_unref(pkt);
+        reportPacketRate();
+    }
+    if (!ctx_.control) {
+        // 有播放控制时队列由播放线程在播放结束后结束
+        packetQueue.setFinished(true);
     }
     ctx_.demuxing_completed = true;
     av_packet_free(&pkt);
@@ -89,73 +139,312 @@ bool Demuxer::openInputWithAudio(const char* url) {
         return false;
     }
 
-    // 查找音频流
-    for (unsigned i = 0; i < ctx_.format_ctx->nb_streams; i++) {
-        if (ctx_.format_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-            audio_ctx_.audio_stream_idx = i;  // 修改为写入 audio_ctx_
-            audio_ctx_.codec_par = ctx_.format_ctx->streams[i]->codecpar;  // 修改为写入 audio_ctx_
-
-            // 查找音频解码器
-            audio_ctx_.codec = avcodec_find_decoder(audio_ctx_.codec_par->codec_id);  // 修改为写入 audio_ctx_
-            if (!audio_ctx_.codec) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "未找到音频解码器");
-                return false;
-            }
+    // 查找音频流，优先选择与视频流相关的那一路
+    if (!selectStream(AVMEDIA_TYPE_AUDIO)) {
+        LOGE(TAG, "未找到音频流");
+        return false;
+    }
 
-            // 分配音频解码器上下文
-            audio_ctx_.codec_ctx = avcodec_alloc_context3(audio_ctx_.codec);  // 修改为写入 audio_ctx_
-            if (!audio_ctx_.codec_ctx) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "无法分配音频解码器上下文");
-                return false;
-            }
+    return true;
+}
 
-            // 从编解码器参数复制到音频解码器上下文
-            if (avcodec_parameters_to_context(audio_ctx_.codec_ctx, audio_ctx_.codec_par) < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "无法复制音频编解码器参数到上下文");
-                avcodec_free_context(&audio_ctx_.codec_ctx);
-                return false;
+// 新增方法：开始解复用视频和音频
+void Demuxer::startWithAudio(SpscQueue<AVPacket*>& videoPacketQueue, SpscQueue<AVPacket*>& audioPacketQueue) {
+    // 按各自流的时间基统计队列缓存时长
+    videoPacketQueue.setTimeBase(ctx_.format_ctx->streams[ctx_.video_stream_idx]->time_base);
+    audioPacketQueue.setTimeBase(ctx_.format_ctx->streams[audio_ctx_.audio_stream_idx]->time_base);
+
+    AVPacket* pkt = av_packet_alloc();
+    while (!ctx_.demuxing_completed) {
+        serviceSeek(videoPacketQueue, &audioPacketQueue);
+        if (holdAfterPreview()) {
+            continue;
+        }
+        if (av_read_frame(ctx_.format_ctx, pkt) < 0) {
+            if (!finishAtEnd(videoPacketQueue, &audioPacketQueue)) {
+                continue;
             }
+            LOGI(TAG, "解复用视频和音频完成");
+            break;
+        }
 
-            // 打开音频解码器
-            if (avcodec_open2(audio_ctx_.codec_ctx, audio_ctx_.codec, nullptr) < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "无法打开音频解码器");
-                avcodec_free_context(&audio_ctx_.codec_ctx);
-                return false;
+        LOGV(TAG, "添加一条消息");
+        // 队列已满时 push 会阻塞，解复用速度由解码速度决定。
+        // seek 请求会让解码线程丢弃旧数据，阻塞的 push 很快返回，下一轮循环执行 seek
+        if (pkt->stream_index == ctx_.video_stream_idx) {
+            keyframes_.addPacket(pkt);
+            if (acceptPacket(pkt)) {
+                pushPacket(pkt, videoPacketQueue);
             }
+        } else if (pkt->stream_index == audio_ctx_.audio_stream_idx && acceptPacket(pkt)) {  // 修改为检查 audio_ctx_ 中的索引
+            pushPacket(pkt, audioPacketQueue);
+        }
+        av_packet_unref(pkt);
+        reportPacketRate();
+    }
 
-            __android_log_print(ANDROID_LOG_INFO, TAG, "找到音频流索引: %d", i);
-            break;
+    QueueStats videoStats = videoPacketQueue.stats();
+    QueueStats audioStats = audioPacketQueue.stats();
+    LOGI(TAG,
+         "视频队列: %zu 个包 %zu 字节 %lld us, 阻塞 %llu 次; 音频队列: %zu 个包 %zu 字节 %lld us, 阻塞 %llu 次",
+         videoStats.packets, videoStats.bytes, (long long)videoStats.durationUs,
+         (unsigned long long)videoStats.blockedPushes,
+         audioStats.packets, audioStats.bytes, (long long)audioStats.durationUs,
+         (unsigned long long)audioStats.blockedPushes);
+    if (!ctx_.control) {
+        // 通知解码线程不会再有新的数据；有播放控制时由播放线程在播放结束后结束队列
+        videoPacketQueue.setFinished(true);
+        audioPacketQueue.setFinished(true);
+    }
+    ctx_.demuxing_completed = true;
+    audio_ctx_.demuxing_completed = true;
+    av_packet_free(&pkt);
+}
+
+std::vector<StreamInfo> Demuxer::streams() const {
+    std::vector<StreamInfo> result;
+    if (!ctx_.format_ctx) {
+        return result;
+    }
+    for (unsigned i = 0; i < ctx_.format_ctx->nb_streams; i++) {
+        const AVStream* st = ctx_.format_ctx->streams[i];
+        StreamInfo info;
+        info.index = static_cast<int>(i);
+        info.type = st->codecpar->codec_type;
+        info.codecId = st->codecpar->codec_id;
+        info.bitRate = st->codecpar->bit_rate;
+        info.attachedPicture = (st->disposition & AV_DISPOSITION_ATTACHED_PIC) != 0;
+        info.selected = info.index == ctx_.video_stream_idx || info.index == audio_ctx_.audio_stream_idx;
+        const AVDictionaryEntry* language = av_dict_get(st->metadata, "language", nullptr, 0);
+        if (language) {
+            info.language = language->value;
         }
+        result.push_back(info);
     }
+    return result;
+}
 
-    if (audio_ctx_.audio_stream_idx == -1) {  // 修改为检查 audio_ctx_ 中的索引
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "未找到音频流");
+bool Demuxer::selectStream(AVMediaType type, int index) {
+    if (!ctx_.format_ctx || (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO)) {
+        return false;
+    }
+    if (index < 0) {
+        // 音频优先选与当前视频流相关的那一路
+        const int related = type == AVMEDIA_TYPE_AUDIO ? ctx_.video_stream_idx : -1;
+        index = av_find_best_stream(ctx_.format_ctx, type, -1, related, nullptr, 0);
+        if (index < 0) {
+            return false;
+        }
+    } else if (index >= static_cast<int>(ctx_.format_ctx->nb_streams) ||
+               ctx_.format_ctx->streams[index]->codecpar->codec_type != type) {
+        LOGE(TAG, "流 %d 不存在或类型不匹配", index);
+        return false;
+    }
+    // 封面图虽然是视频流，但只有一帧，不能作为播放的视频
+    AVStream* st = ctx_.format_ctx->streams[index];
+    if (type == AVMEDIA_TYPE_VIDEO && (st->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+        LOGE(TAG, "流 %d 是封面图", index);
         return false;
     }
 
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        ctx_.video_stream_idx = index;
+        ctx_.codec_par = st->codecpar;
+        LOGI(TAG, "找到视频流索引: %d", index);
+    } else {
+        audio_ctx_.audio_stream_idx = index;
+        audio_ctx_.codec_par = st->codecpar;
+        audio_ctx_.time_base = st->time_base;
+        LOGI(TAG, "找到音频流索引: %d", index);
+    }
+    applyStreamDiscard();
     return true;
 }
 
-// 新增方法：开始解复用视频和音频
-void Demuxer::startWithAudio(PacketQueue<AVPacket*>& videoPacketQueue, PacketQueue<AVPacket*>& audioPacketQueue) {
-    AVPacket* pkt = av_packet_alloc();
-    while (!ctx_.demuxing_completed) {
-        if (av_read_frame(ctx_.format_ctx, pkt) < 0) {
-            __android_log_print(ANDROID_LOG_INFO, TAG, "解复用视频和音频完成");
-            break;
+// 没有选中的流设为 AVDISCARD_ALL，支持的容器（MKV cues、MP4 sample table 等）会直接跳过这些数据
+void Demuxer::applyStreamDiscard() {
+    int discarded = 0;
+    for (unsigned i = 0; i < ctx_.format_ctx->nb_streams; i++) {
+        const int index = static_cast<int>(i);
+        const bool selected = index == ctx_.video_stream_idx || index == audio_ctx_.audio_stream_idx;
+        ctx_.format_ctx->streams[i]->discard = selected ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+        if (!selected) {
+            discarded++;
         }
+    }
+    if (discarded > 0) {
+        LOGI(TAG, "丢弃 %d 路未使用的流", discarded);
+    }
+}
 
-        __android_log_print(ANDROID_LOG_INFO, TAG, "添加一条消息");
-        if (pkt->stream_index == ctx_.video_stream_idx) {
-            AVPacket* cloned = av_packet_clone(pkt);
-            videoPacketQueue.push(cloned);
-        } else if (pkt->stream_index == audio_ctx_.audio_stream_idx) {  // 修改为检查 audio_ctx_ 中的索引
-            AVPacket* cloned = av_packet_clone(pkt);
-            audioPacketQueue.push(cloned);
+void Demuxer::serviceSeek(SpscQueue<AVPacket*>& videoQueue, SpscQueue<AVPacket*>* audioQueue) {
+    SeekRequest request;
+    if (!ctx_.control || !ctx_.control->takeSeek(&request)) {
+        return;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    if (!seekToKeyframe(request)) {
+        // 定位失败时从当前位置继续，标记包照常放入，解码线程才能恢复
+        LOGE(TAG, "seek 到 %.3fs 失败", request.targetUs / 1000000.0);
+    }
+    // seek 之后读到的关键帧与之前记录的不连续
+    keyframes_.resetScan();
+    previewing_ = request.mode == SeekMode::Preview;
+    previewSent_ = false;
+    pushSeekMarker(request, videoQueue);
+    if (audioQueue) {
+        pushSeekMarker(request, *audioQueue);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    ctx_.control->onSeekPerformed(request,
+                                  std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+bool Demuxer::seekToKeyframe(const SeekRequest& request) {
+    AVFormatContext* fmt = ctx_.format_ctx;
+    AVStream* st = fmt->streams[ctx_.video_stream_idx];
+    keyframes_.importFromStream(st);
+    const int64_t targetUs = request.targetUs;
+    const int64_t target = av_rescale_q(targetUs, AV_TIME_BASE_Q, st->time_base);
+
+    // 精确 seek 要从目标之前的关键帧开始解码，不能落在目标之后
+    KeyframeEntry keyframe;
+    const bool found = request.mode == SeekMode::Accurate ? keyframes_.atOrBefore(target, &keyframe)
+                                                         : keyframes_.nearest(target, &keyframe);
+    if (found) {
+        int ret;
+        if (!keyframe.fromContainer && keyframe.pos >= 0 && !(fmt->iformat->flags & AVFMT_NO_BYTE_SEEK)) {
+            // 解复用时记录下的关键帧，按字节位置直接跳过去
+            ret = av_seek_frame(fmt, ctx_.video_stream_idx, keyframe.pos, AVSEEK_FLAG_BYTE);
+        } else {
+            ret = avformat_seek_file(fmt, ctx_.video_stream_idx, INT64_MIN, keyframe.timestamp,
+                                     keyframe.timestamp, 0);
         }
-        av_packet_unref(pkt);
+        if (ret >= 0) {
+            LOGD(TAG, "seek 到关键帧 %.3fs (目标 %.3fs)",
+                 keyframe.timestamp * av_q2d(st->time_base), targetUs / 1000000.0);
+            return true;
+        }
+        LOGW(TAG, "按关键帧索引 seek 失败: %d", ret);
     }
-    __android_log_print(ANDROID_LOG_INFO, "VideoPacketQueue", "队列长度: %d", audioPacketQueue.size());
-    //ctx_.demuxing_completed = true;
-    av_packet_free(&pkt);
-}
\ No newline at end of file
+    // 索引中没有可信的关键帧，交给容器定位到目标之前的关键帧
+    return av_seek_frame(fmt, ctx_.video_stream_idx, target, AVSEEK_FLAG_BACKWARD) >= 0;
+}
+
+void Demuxer::pushSeekMarker(const SeekRequest& request, SpscQueue<AVPacket*>& queue) {
+    PooledPacket marker = ctx_.packet_pool ? ctx_.packet_pool->acquire()
+                                           : PooledPacket(nullptr, av_packet_alloc());
+    if (!marker) {
+        LOGE(TAG, "分配标记包失败");
+        return;
+    }
+    makeSeekMarker(marker.get(), request);
+    if (queue.push(marker.get())) {
+        marker.release();
+    }
+}
+
+bool Demuxer::finishAtEnd(SpscQueue<AVPacket*>& videoQueue, SpscQueue<AVPacket*>* audioQueue) {
+    if (previewing_) {
+        // 预览位置之后没有关键帧了，同样停下来等下一个请求，不结束播放
+        previewSent_ = true;
+        return false;
+    }
+    if (!ctx_.control) {
+        return true;
+    }
+    // 队列里可能还有几秒的数据没有播放。通知解码线程排空解码器，然后停在这里：
+    // 这期间的 seek 照常执行，播放结束后 close 让这里返回
+    pushEndMarker(videoQueue);
+    if (audioQueue) {
+        pushEndMarker(*audioQueue);
+    }
+    LOGI(TAG, "读到文件结尾，等待 seek 或播放结束");
+    return !ctx_.control->waitForSeek();
+}
+
+bool Demuxer::holdAfterPreview() {
+    if (!previewing_ || !previewSent_) {
+        return false;
+    }
+    if (!ctx_.control->waitForSeek()) {
+        // 已经关闭，不再等待
+        ctx_.demuxing_completed = true;
+    }
+    return true;
+}
+
+void Demuxer::pushEndMarker(SpscQueue<AVPacket*>& queue) {
+    PooledPacket marker = ctx_.packet_pool ? ctx_.packet_pool->acquire()
+                                           : PooledPacket(nullptr, av_packet_alloc());
+    if (!marker) {
+        LOGE(TAG, "分配结束标记包失败");
+        return;
+    }
+    makeEndOfStreamMarker(marker.get());
+    if (queue.push(marker.get())) {
+        marker.release();
+    }
+}
+
+bool Demuxer::acceptPacket(const AVPacket* pkt) {
+    if (!previewing_) {
+        return true;
+    }
+    // 预览只显示画面，音频包和关键帧之前的非关键帧都不需要
+    if (pkt->stream_index != ctx_.video_stream_idx || previewSent_ || !(pkt->flags & AV_PKT_FLAG_KEY)) {
+        return false;
+    }
+    previewSent_ = true;
+    return true;
+}
+
+void Demuxer::markPhase(StartupPhase phase) {
+    if (ctx_.startup_trace) {
+        ctx_.startup_trace->mark(phase);
+    }
+}
+
+// 把读到的包移动到回收池的外壳中再入队，不再为每个包 av_packet_clone
+bool Demuxer::pushPacket(AVPacket* pkt, SpscQueue<AVPacket*>& queue) {
+    PooledPacket pooled = ctx_.packet_pool ? ctx_.packet_pool->acquireMoved(pkt)
+                                           : PooledPacket(nullptr, av_packet_alloc());
+    if (!pooled) {
+        LOGE(TAG, "分配 AVPacket 失败");
+        return false;
+    }
+    if (!ctx_.packet_pool) {
+        av_packet_move_ref(pooled.get(), pkt);
+    }
+    if (!queue.push(pooled.get())) {
+        // 队列已结束，pooled 析构时归还
+        return false;
+    }
+    pooled.release();
+    markPhase(StartupPhase::FirstPacket);
+    return true;
+}
+
+// 每秒输出一次 AVPacket 的分配速率，用于观察回收池的效果
+void Demuxer::reportPacketRate() {
+    if (!ctx_.packet_pool) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (lastRateReport_.time_since_epoch().count() == 0) {
+        lastRateReport_ = now;
+        lastPoolStats_ = ctx_.packet_pool->stats();
+        return;
+    }
+    double seconds = std::chrono::duration<double>(now - lastRateReport_).count();
+    if (seconds < 1.0) {
+        return;
+    }
+    PacketPoolStats stats = ctx_.packet_pool->stats();
+    LOGI(TAG, "AVPacket 分配 %.1f 次/秒, 取用 %.1f 次/秒, 池中空闲 %zu",
+         (stats.allocations - lastPoolStats_.allocations) / seconds,
+         (stats.acquires - lastPoolStats_.acquires) / seconds,
+         stats.cached);
+    lastRateReport_ = now;
+    lastPoolStats_ = stats;
+}
@@ -0,0 +1,26 @@
+#include "fileio.h"
+#include "mappedfileio.h"
+#include "readaheadfileio.h"
+#include <cstring>
+
+const char* FileIO::localPath(const char* url) {
+    if (!url) {
+        return nullptr;
+    }
+    if (std::strncmp(url, "file:", 5) == 0) {
+        return url + 5;
+    }
+    return std::strstr(url, "://") ? nullptr : url;
+}
+
+std::unique_ptr<FileIO> FileIO::create(FileIOMode mode) {
+    switch (mode) {
+        case FileIOMode::Mapped:
+            return std::unique_ptr<FileIO>(new MappedFileIO());
+        case FileIOMode::ReadAhead:
+            return std::unique_ptr<FileIO>(new ReadAheadFileIO());
+        case FileIOMode::Default:
+        default:
+            return nullptr;
+    }
+}
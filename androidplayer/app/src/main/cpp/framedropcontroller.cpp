@@ -0,0 +1,68 @@
+#include "framedropcontroller.h"
+
+const char* dropTierName(DropTier tier) {
+    switch (tier) {
+        case DropTier::None: return "正常";
+        case DropTier::DropLate: return "丢弃晚到帧";
+        case DropTier::SkipLoopFilter: return "跳过环路滤波";
+        case DropTier::SkipNonRef: return "跳过非参考帧";
+        case DropTier::KeyframeOnly: return "只解码关键帧";
+    }
+    return "未知";
+}
+
+bool FrameDropController::update(int64_t lateUs, int64_t nowUs, DropTier* previous) {
+    if (lateUs > kBehindUs) {
+        caughtUpSinceUs_ = kUnset;
+        if (behindSinceUs_ == kUnset) {
+            behindSinceUs_ = nowUs;
+        }
+    } else {
+        behindSinceUs_ = kUnset;
+        if (lateUs > kCaughtUpUs) {
+            // 介于两者之间：不降级也不计入跟上的时间
+            caughtUpSinceUs_ = kUnset;
+            return false;
+        }
+        if (caughtUpSinceUs_ == kUnset) {
+            caughtUpSinceUs_ = nowUs;
+        }
+    }
+    if (lastChangeUs_ != kUnset && nowUs - lastChangeUs_ < kMinHoldUs) {
+        return false;
+    }
+
+    *previous = tier_;
+    if (behindSinceUs_ != kUnset && nowUs - behindSinceUs_ >= kEscalateAfterUs) {
+        if (tier_ == DropTier::KeyframeOnly) {
+            return false;
+        }
+        if (lastRecoverUs_ != kUnset && nowUs - lastRecoverUs_ < kOscillationUs &&
+            recoverAfterUs_ < kMaxRecoverAfterUs) {
+            recoverAfterUs_ *= 2;
+        }
+        tier_ = static_cast<DropTier>(static_cast<int>(tier_) + 1);
+    } else if (caughtUpSinceUs_ != kUnset && nowUs - caughtUpSinceUs_ >= recoverAfterUs_) {
+        if (tier_ == DropTier::None) {
+            return false;
+        }
+        tier_ = static_cast<DropTier>(static_cast<int>(tier_) - 1);
+        lastRecoverUs_ = nowUs;
+    } else {
+        return false;
+    }
+    // 新档位重新开始观察
+    lastChangeUs_ = nowUs;
+    behindSinceUs_ = kUnset;
+    caughtUpSinceUs_ = kUnset;
+    return true;
+}
+
+bool FrameDropController::shouldDrop(int64_t lateUs) const {
+    return tier_ != DropTier::None && lateUs > kDropLateUs;
+}
+
+void FrameDropController::resetObservation() {
+    behindSinceUs_ = kUnset;
+    caughtUpSinceUs_ = kUnset;
+}
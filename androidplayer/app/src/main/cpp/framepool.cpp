@@ -0,0 +1,113 @@
+#include "framepool.h"
+#include "log.h"
+extern "C" {
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+}
+
+#define TAG "FramePool"
+
+FramePool::FramePool(int align) : align_(align) {}
+
+FramePool::~FramePool() {
+    // 还在渲染队列中的帧仍持有缓冲区，池会在它们全部归还后释放
+    av_buffer_pool_uninit(&pool_);
+}
+
+AVFrame* FramePool::acquire(AVPixelFormat format, int width, int height) {
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        return nullptr;
+    }
+    if (!fill(frame, format, width, height)) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    return frame;
+}
+
+bool FramePool::fill(AVFrame* frame, AVPixelFormat format, int width, int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pool_ || format != format_ || width != width_ || height != height_) {
+        if (!rebuildLocked(format, width, height)) {
+            return false;
+        }
+    }
+
+    AVBufferRef* buf = av_buffer_pool_get(pool_);
+    if (!buf) {
+        LOGE(TAG, "从缓冲池取帧失败");
+        return false;
+    }
+
+    // av_malloc 只保证 16 字节对齐（ARM 上），起始地址在这里补齐到 align_，余量已经算在 bufferSize_ 里
+    uint8_t* base = reinterpret_cast<uint8_t*>(FFALIGN(reinterpret_cast<uintptr_t>(buf->data), (uintptr_t)align_));
+    frame->buf[0] = buf;
+    for (int i = 0; i < 4 && planeSize_[i] > 0; i++) {
+        frame->data[i] = base + planeOffset_[i];
+        frame->linesize[i] = linesize_[i];
+    }
+    frame->extended_data = frame->data;
+    acquires_++;
+    return true;
+}
+
+FramePoolStats FramePool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FramePoolStats stats;
+    stats.acquires = acquires_;
+    stats.rebuilds = rebuilds_;
+    stats.bufferSize = bufferSize_;
+    return stats;
+}
+
+bool FramePool::rebuildLocked(AVPixelFormat format, int width, int height) {
+    av_buffer_pool_uninit(&pool_);
+    format_ = AV_PIX_FMT_NONE;
+
+    // 与 av_frame_get_buffer 相同的对齐方式：宽度和每行字节数都按 align_ 对齐
+    int linesize[4] = {0};
+    if (av_image_fill_linesizes(linesize, format, FFALIGN(width, align_)) < 0) {
+        LOGE(TAG, "不支持的像素格式: %d", format);
+        return false;
+    }
+    ptrdiff_t linesizes[4];
+    for (int i = 0; i < 4; i++) {
+        linesize[i] = FFALIGN(linesize[i], align_);
+        linesizes[i] = linesize[i];
+    }
+
+    size_t sizes[4] = {0};
+    if (av_image_fill_plane_sizes(sizes, format, height, linesizes) < 0) {
+        LOGE(TAG, "计算平面大小失败");
+        return false;
+    }
+
+    // 所有平面放在同一块缓冲区里，每个平面的起始地址同样按 align_ 对齐
+    size_t offset = 0;
+    for (int i = 0; i < 4; i++) {
+        planeOffset_[i] = offset;
+        planeSize_[i] = sizes[i];
+        linesize_[i] = linesize[i];
+        offset += FFALIGN(sizes[i], (size_t)align_);
+    }
+    // 末尾留出 SIMD 读越界的余量，以及 fill 中把起始地址对齐到 align_ 时最多跳过的 align_ - 1 字节
+    bufferSize_ = offset + 16 + align_ - 1;
+
+    pool_ = av_buffer_pool_init(bufferSize_, nullptr);
+    if (!pool_) {
+        LOGE(TAG, "创建缓冲池失败");
+        return false;
+    }
+    format_ = format;
+    width_ = width;
+    height_ = height;
+    rebuilds_++;
+    LOGI(TAG, "重建帧缓冲池 %dx%d %s, 每帧 %zu 字节",
+         width, height, av_get_pix_fmt_name(format), bufferSize_);
+    return true;
+}
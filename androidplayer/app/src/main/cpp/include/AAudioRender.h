@@ -2,7 +2,7 @@
 #define AAUDIO_RENDER_H
 
 #include <aaudio/AAudio.h>
-#include "RingBuffer.h"  // 添加环形缓冲区头文件
+#include "audioplayback.h"
 
 // AAudio使用的回调函数定义。第一个参数为当前的音频流，第二个参数是用户设置的数据指针，
 // 第三个参数是AAudio提供的音频缓冲区，需要在回调中向该缓冲区写入pcm数据，需要写入的
@@ -33,7 +33,7 @@ public:
     // 参数p为true时表示暂停，为false时表示取消暂停
     int pause(bool p);
 
-    // 声明回调函数
+    // 声明回调函数，user_data 为 AudioPlaybackState*
     static int audioCallback(AAudioStream* stream, void* user_data, void* audio_data, int32_t num_frames);
     static int myAudioCallback(AAudioStream* stream, void* userData, void* buffer, int32_t num_frames);
 };
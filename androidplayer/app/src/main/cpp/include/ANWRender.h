@@ -11,16 +11,26 @@
 #include <stdint.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
+#include "videosink.h"
 
-class ANWRender{
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+// ANativeWindow 显示后端：不使用 GL，sws_scale 把 YUV 直接转换到锁定的窗口缓冲区里
+class ANWRender : public IVideoSink {
 public:
     ANWRender(ANativeWindow *window);
-    int init(int videoWidth, int videoHeight);
-    int render(uint8_t* rgba);
+    ~ANWRender() override;
+
+    bool init() override;
+    bool render(const AVFrame* frame) override;
+    const char* name() const override { return "ANativeWindow"; }
 
 private:
     ANativeWindow *native_window;
-    int width;
-    int height;
+    SwsContext *sws_ctx = nullptr;
+    int width = 0;
+    int height = 0;
 };
 #endif
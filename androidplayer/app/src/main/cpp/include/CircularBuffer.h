@@ -1,30 +1,75 @@
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
-#include <vector>
-#include <mutex>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 extern "C" {
 #include <libavutil/frame.h>
 }
 
-template <typename T>
+struct CircularBufferStats {
+    uint64_t written = 0;      // 写入的帧数
+    uint64_t overwritten = 0;  // 渲染线程卡住时被覆盖、没有显示的帧数
+    size_t ready = 0;          // 当前等待显示的帧数
+};
+
+// 解码→渲染的显示信箱：固定数量的槽位，AVFrame 在构造时全部分配好，
+// 写入时把解码帧的缓冲区引用移入空槽位，不再每帧 av_frame_alloc。
+// 正常情况下槽位满了生产者就等待，由渲染线程的节奏反压解码；
+// 渲染线程超过 stallTimeout 没有取帧也没有调用 keepAlive（Surface 忙、应用切到后台等）时，
+// 生产者直接覆盖最旧的未显示帧并计入 overwritten，延迟和内存占用都不会超过固定的槽位数。
+// 只允许一个生产者和一个消费者，消费者同一时刻最多持有一帧。
 class CircularBuffer {
 public:
-    explicit CircularBuffer(int capacity);
-    void write(T item);
-    T read();
+    explicit CircularBuffer(int capacity,
+                            std::chrono::milliseconds stallTimeout = std::chrono::milliseconds(250));
+    ~CircularBuffer();
+
+    CircularBuffer(const CircularBuffer&) = delete;
+    CircularBuffer& operator=(const CircularBuffer&) = delete;
+
+    // 生产者：把 frame 的引用移入槽位，成功后 frame 为空，调用者仍负责释放 frame 本身。
+    // 已经 finished 时返回 false，frame 保持不变
+    bool write(AVFrame* frame);
+    // 消费者：取出最旧的帧，没有帧时阻塞；已 finished 且没有帧时返回 nullptr。
+    // 返回的帧归信箱所有，用完后交给 release，再次 read 之前必须归还
+    AVFrame* read();
+    void release(AVFrame* frame);
+    // 消费者：仍在正常工作（例如在等待帧的显示时间），生产者不要覆盖
+    void keepAlive();
+
+    void setFinished(bool finished);
+    // 已 finished 且所有帧都被取走
+    bool isFinished() const;
     bool isEmpty() const;
     bool isFull() const;
 
+    CircularBufferStats stats() const;
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    bool isEmptyLocked() const { return count_ == 0; }
+    bool isFullLocked() const { return count_ == capacity_ || free_.empty(); }
+
     int capacity_;
-    int readIndex_;
-    int writeIndex_;
-    std::vector<T> buffer_;
+    std::chrono::milliseconds stallTimeout_;
+    std::vector<AVFrame*> frames_;  // 全部槽位，析构时释放
+    std::vector<AVFrame*> buffer_;  // 等待显示的帧，环形
+    std::vector<AVFrame*> free_;    // 空槽位
+    int readIndex_ = 0;
+    int writeIndex_ = 0;
+    int count_ = 0;
+    Clock::time_point consumerActive_;  // 消费者最近一次取帧或 keepAlive 的时刻
+    bool finished_ = false;
+    uint64_t written_ = 0;
+    uint64_t overwritten_ = 0;
     mutable std::mutex mutex_;
     std::condition_variable condNotEmpty_;
     std::condition_variable condNotFull_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,82 +1,236 @@
 #ifndef RINGBUFFER_H
 #define RINGBUFFER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <thread>
 #include <vector>
-#include <mutex>
-#include <condition_variable>
 
+// 单生产者单消费者的环形缓冲区，读写位置都是原子变量，不使用锁和条件变量。
+// 消费者（AAudio 实时回调）一侧是 wait-free 的：read 只取当前可读的数据，不会等待。
+// 生产者（音频解码线程）在空间不足时通过短暂休眠轮询等待，不会阻塞消费者。
+//
+// 除了带拷贝的 write/read，还提供两阶段的零拷贝接口：
+// beginWrite/commitWrite 暴露可写的连续区域，调用者（例如 swr_convert）直接写入缓冲区；
+// beginRead/commitRead 暴露可读的连续区域。由于回绕，一次最多得到两段连续区域。
+//
+// 读位置只由消费者修改。生产者需要清空缓冲区（seek）时用 requestDiscard 记下当前的写位置，
+// 消费者在下一次读之前调用 applyDiscard 跳过这些数据。
 template <typename T>
 class RingBuffer {
 public:
-    RingBuffer(size_t size) : buffer(size), capacity(size), read_pos(0), write_pos(0), count(0) {}
+    // 一段连续的内存区域
+    struct Span {
+        T* data = nullptr;
+        size_t size = 0;
+    };
+
+    // beginWrite/beginRead 返回的区域，second 只在回绕时非空
+    struct Region {
+        Span first;
+        Span second;
+
+        size_t total() const {
+            return first.size + second.size;
+        }
+    };
+
+    RingBuffer(size_t size) : buffer(size), capacity(size) {}
 
     ~RingBuffer() {}
 
+    // 生产者：阻塞直到全部写入，或者缓冲区被 close
     size_t write(const T* data, size_t size) {
-        std::unique_lock<std::mutex> lock(mutex);
-        // 等待缓冲区有足够的写入空间
-        condNotFull.wait(lock, [this, size] { return available_write() >= size; });
-
-        size_t to_write = size;
-        if (to_write > 0) {
-            size_t first_part = (capacity - write_pos < to_write) ? capacity - write_pos : to_write;
-            std::memcpy(buffer.data() + write_pos, data, first_part * sizeof(T));
-            std::memcpy(buffer.data(), data + first_part, (to_write - first_part) * sizeof(T));
-            write_pos = (write_pos + to_write) % capacity;
-            count += to_write;
+        size_t written = 0;
+        while (written < size) {
+            written += tryWrite(data + written, size - written);
+            if (written == size || closed.load(std::memory_order_acquire)) {
+                break;
+            }
+            // 等待回调把数据取走，消费者不会主动通知生产者
+            std::this_thread::sleep_for(std::chrono::milliseconds(kWriteWaitMs));
         }
-        // 通知可能正在等待数据的线程
-        condNotEmpty.notify_one();
-        return to_write;
+        return written;
+    }
+
+    // 生产者：尽可能多地写入，不等待
+    size_t tryWrite(const T* data, size_t size) {
+        Region region = beginWrite(size);
+        std::memcpy(region.first.data, data, region.first.size * sizeof(T));
+        std::memcpy(region.second.data, data + region.first.size, region.second.size * sizeof(T));
+        commitWrite(region.total());
+        return region.total();
     }
 
+    // 消费者：wait-free，最多读取 size 个元素，返回实际读取的个数
     size_t read(T* data, size_t size) {
-        std::unique_lock<std::mutex> lock(mutex);
-        // 等待缓冲区有足够的数据可读
-        condNotEmpty.wait(lock, [this, size] { return available_read() >= size; });
-
-        size_t to_read = size;
-        if (to_read > 0) {
-            size_t first_part = (capacity - read_pos < to_read) ? capacity - read_pos : to_read;
-            std::memcpy(data, buffer.data() + read_pos, first_part * sizeof(T));
-            std::memcpy(data + first_part, buffer.data(), (to_read - first_part) * sizeof(T));
-            read_pos = (read_pos + to_read) % capacity;
-            count -= to_read;
+        Region region = beginRead(size);
+        std::memcpy(data, region.first.data, region.first.size * sizeof(T));
+        std::memcpy(data + region.first.size, region.second.data, region.second.size * sizeof(T));
+        commitRead(region.total());
+        return region.total();
+    }
+
+    // 生产者：等待直到至少有 size 个元素的可写空间，缓冲区被 close 时返回 false
+    bool waitForWrite(size_t size) {
+        if (size > capacity) {
+            size = capacity;
+        }
+        while (available_write() < size) {
+            if (closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kWriteWaitMs));
+        }
+        return !closed.load(std::memory_order_acquire);
+    }
+
+    // 生产者：同 waitForWrite，cancelled() 返回 true 时不再等待并返回 false
+    template <typename Cancelled>
+    bool waitForWrite(size_t size, Cancelled cancelled) {
+        if (size > capacity) {
+            size = capacity;
+        }
+        while (available_write() < size) {
+            if (closed.load(std::memory_order_acquire) || cancelled()) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kWriteWaitMs));
+        }
+        return !closed.load(std::memory_order_acquire) && !cancelled();
+    }
+
+    // 生产者：丢弃目前已经写入、还没有被读走的全部数据，由消费者下一次 applyDiscard 时执行
+    void requestDiscard() {
+        discard_pos.store(write_pos.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        discard_requests.fetch_add(1, std::memory_order_release);
+    }
+
+    // 消费者：执行生产者请求的丢弃，wait-free。有新的丢弃请求时返回 true
+    bool applyDiscard() {
+        const uint32_t requests = discard_requests.load(std::memory_order_acquire);
+        if (requests == discards_applied.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const size_t target = discard_pos.load(std::memory_order_relaxed);
+        const size_t r = read_pos.load(std::memory_order_relaxed);
+        // 位置单调递增，差值按有符号数比较以兼容回绕
+        if (static_cast<std::ptrdiff_t>(target - r) > 0) {
+            read_pos.store(target, std::memory_order_release);
+        }
+        discards_applied.store(requests, std::memory_order_release);
+        return true;
+    }
+
+    bool discardPending() const {
+        return discard_requests.load(std::memory_order_acquire) !=
+               discards_applied.load(std::memory_order_acquire);
+    }
+
+    // 生产者：等待消费者执行完丢弃，缓冲区被 close 或超过 timeoutMs 时返回 false
+    bool waitForDiscard(int timeoutMs) {
+        for (int waited = 0; discardPending(); waited += kWriteWaitMs) {
+            if (closed.load(std::memory_order_acquire) || waited >= timeoutMs) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kWriteWaitMs));
+        }
+        return true;
+    }
+
+    // 生产者：获取最多 maxSize 个元素的可写区域，不等待。写完后调用 commitWrite 提交实际写入的个数
+    Region beginWrite(size_t maxSize) {
+        const size_t w = write_pos.load(std::memory_order_relaxed);
+        const size_t r = read_pos.load(std::memory_order_acquire);
+        size_t size = capacity - (w - r);
+        if (size > maxSize) {
+            size = maxSize;
+        }
+        return regionAt(w, size);
+    }
+
+    // 生产者：提交 beginWrite 区域中前 count 个元素，count 不能超过区域大小
+    void commitWrite(size_t count) {
+        if (count > 0) {
+            write_pos.store(write_pos.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+    }
+
+    // 消费者：获取最多 maxSize 个元素的可读区域，wait-free。读完后调用 commitRead 释放
+    Region beginRead(size_t maxSize) {
+        const size_t r = read_pos.load(std::memory_order_relaxed);
+        const size_t w = write_pos.load(std::memory_order_acquire);
+        size_t size = w - r;
+        if (size > maxSize) {
+            size = maxSize;
+        }
+        return regionAt(r, size);
+    }
+
+    // 消费者：释放 beginRead 区域中前 count 个元素
+    void commitRead(size_t count) {
+        if (count > 0) {
+            read_pos.store(read_pos.load(std::memory_order_relaxed) + count, std::memory_order_release);
         }
-        // 通知可能正在等待写入空间的线程
-        condNotFull.notify_one();
-        return to_read;
     }
 
     size_t available_read() const {
-        return count;
+        return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire);
     }
 
     size_t available_write() const {
-        return capacity - count;
+        return capacity - available_read();
     }
 
     bool isEmpty() const {
-        std::unique_lock<std::mutex> lock(mutex);
-        return count == 0;
+        return available_read() == 0;
     }
 
     bool isFull() const {
-        std::unique_lock<std::mutex> lock(mutex);
-        return count == capacity;
+        return available_read() == capacity;
+    }
+
+    // 停止阻塞写入，用于消费者已经不再读取（播放停止、音频设备打开失败）的情况
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+
+    bool isClosed() const {
+        return closed.load(std::memory_order_acquire);
+    }
+
+    size_t buffer_size() const {
+        return capacity;
     }
 
 private:
+    static constexpr int kWriteWaitMs = 2;
+
+    // 把从位置 pos 开始的 size 个元素拆成最多两段连续区域
+    Region regionAt(size_t pos, size_t size) {
+        Region region;
+        const size_t index = pos % capacity;
+        const size_t first_part = (capacity - index < size) ? capacity - index : size;
+        region.first.data = buffer.data() + index;
+        region.first.size = first_part;
+        region.second.data = buffer.data();
+        region.second.size = size - first_part;
+        return region;
+    }
+
     std::vector<T> buffer;
     size_t capacity;
-    size_t read_pos;
-    size_t write_pos;
-    size_t count;
-    mutable std::mutex mutex;
-    std::condition_variable condNotFull;
-    std::condition_variable condNotEmpty;
+    // 读写位置单调递增，取模得到下标；分开放在不同缓存行，避免读写两端互相干扰
+    alignas(64) std::atomic<size_t> read_pos{0};
+    alignas(64) std::atomic<size_t> write_pos{0};
+    std::atomic<bool> closed{false};
+    // 丢弃请求：生产者写 discard_pos 和 discard_requests，消费者执行后更新 discards_applied
+    std::atomic<size_t> discard_pos{0};
+    std::atomic<uint32_t> discard_requests{0};
+    std::atomic<uint32_t> discards_applied{0};
 };
 
-#endif // RINGBUFFER_H
\ No newline at end of file
+#endif // RINGBUFFER_H
@@ -0,0 +1,248 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "queue.h"  // QueueLimits / QueueStats / queueItemBytes
+
+// 单生产者单消费者无锁队列，用于 解复用→解码 和 解码→渲染 这类一对一的链路。
+// push 只能在一个线程调用，pop 只能在另一个线程调用。
+// 正常收发只有原子读写，只有队列确实为空（消费者）或已满（生产者）时才会短暂自旋后挂起线程。
+// 除了固定的槽位容量外，同样支持 QueueLimits 中的字节数和时长上限。
+template <typename T>
+class SpscQueue {
+public:
+    static constexpr size_t kCacheLine = 64;
+
+    explicit SpscQueue(size_t capacity, const QueueLimits& limits = QueueLimits())
+            : limits_(limits) {
+        capacity_ = 1;
+        while (capacity_ < capacity) {
+            capacity_ <<= 1;
+        }
+        mask_ = capacity_ - 1;
+        slots_.reset(new T[capacity_]());
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 生产者：队列满时阻塞；如果在等待期间队列被标记为 finished，返回 false，元素仍归调用者所有
+    bool push(T item) {
+        int spins = 0;
+        bool blocked = false;
+        while (!tryPush(item)) {
+            if (finished_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (!blocked) {
+                blocked = true;
+                blockedPushes_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (spins < kSpinCount) {
+                ++spins;
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(parkMutex_);
+            producerWaiting_.store(true, std::memory_order_relaxed);
+            // 声明等待后再检查一次，避免错过消费者的唤醒。
+            // 与 tryPop 中 head_ 写入之后的 fence 配对：要么这里看到新的 head_，要么对方看到 producerWaiting_
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!isFullForProducer() || finished_.load(std::memory_order_acquire)) {
+                producerWaiting_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            condNotFull_.wait(lock);
+            producerWaiting_.store(false, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // 生产者：非阻塞入队，队列满时返回 false
+    bool tryPush(T item) {
+        if (isFullForProducer()) {
+            return false;
+        }
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        slots_[tail & mask_] = item;
+        bytes_.fetch_add(queueItemBytes(item), std::memory_order_relaxed);
+        durationUs_.fetch_add(itemDurationUs(item), std::memory_order_relaxed);
+        totalPushed_.fetch_add(1, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumerWaiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(parkMutex_);
+            condNotEmpty_.notify_one();
+        }
+        return true;
+    }
+
+    // 消费者：队列为空时阻塞，队列为空且已标记 finished 时返回 nullptr
+    T pop() {
+        T item;
+        int spins = 0;
+        while (!tryPop(item)) {
+            if (finished_.load(std::memory_order_acquire)) {
+                // finished 之前入队的元素仍然要取完
+                if (tryPop(item)) {
+                    return item;
+                }
+                return nullptr;
+            }
+            if (spins < kSpinCount) {
+                ++spins;
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(parkMutex_);
+            consumerWaiting_.store(true, std::memory_order_relaxed);
+            // 与 tryPush 中 tail_ 写入之后的 fence 配对
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (tail_.load(std::memory_order_acquire) != head_.load(std::memory_order_relaxed) ||
+                finished_.load(std::memory_order_acquire)) {
+                consumerWaiting_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            condNotEmpty_.wait(lock);
+            consumerWaiting_.store(false, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // 消费者：非阻塞出队，队列为空时返回 false
+    bool tryPop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        item = slots_[head & mask_];
+        slots_[head & mask_] = T();
+        bytes_.fetch_sub(queueItemBytes(item), std::memory_order_relaxed);
+        durationUs_.fetch_sub(itemDurationUs(item), std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producerWaiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(parkMutex_);
+            condNotFull_.notify_one();
+        }
+        return true;
+    }
+
+    void setFinished(bool finished) {
+        std::lock_guard<std::mutex> lock(parkMutex_);
+        finished_.store(finished, std::memory_order_seq_cst);
+        condNotEmpty_.notify_all();
+        condNotFull_.notify_all();
+    }
+
+    bool isFinished() const {
+        return finished_.load(std::memory_order_acquire) && size() == 0;
+    }
+
+    size_t size() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // 设置元素 duration 所使用的时间基，需在开始 push 之前调用
+    void setTimeBase(AVRational timeBase) {
+        timeBase_ = timeBase;
+    }
+
+    QueueStats stats() const {
+        QueueStats stats;
+        stats.packets = size();
+        stats.bytes = bytes_.load(std::memory_order_relaxed);
+        stats.durationUs = durationUs_.load(std::memory_order_relaxed);
+        stats.totalPushed = totalPushed_.load(std::memory_order_relaxed);
+        stats.blockedPushes = blockedPushes_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    static constexpr int kSpinCount = 64;
+
+    int64_t itemDurationUs(T item) const {
+        int64_t duration = queueItemDuration(item);
+        if (duration <= 0 || timeBase_.num <= 0 || timeBase_.den <= 0) {
+            return 0;
+        }
+        return av_rescale_q(duration, timeBase_, AV_TIME_BASE_Q);
+    }
+
+    // 只在生产者线程调用：槽位已满，或者在队列非空时超过字节/时长上限
+    bool isFullForProducer() {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ >= capacity_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ >= capacity_) {
+                return true;
+            }
+        }
+        if (limits_.maxBytes == 0 && limits_.maxDurationUs == 0 && limits_.maxPackets == 0) {
+            return false;
+        }
+        const size_t count = tail - head_.load(std::memory_order_acquire);
+        if (count == 0) {
+            return false;
+        }
+        if (limits_.maxPackets > 0 && count >= limits_.maxPackets) {
+            return true;
+        }
+        if (limits_.maxBytes > 0 && bytes_.load(std::memory_order_relaxed) >= limits_.maxBytes) {
+            return true;
+        }
+        if (limits_.maxDurationUs > 0 &&
+            durationUs_.load(std::memory_order_relaxed) >= limits_.maxDurationUs) {
+            return true;
+        }
+        return false;
+    }
+
+    // 消费者独占的缓存行
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;
+
+    // 生产者独占的缓存行
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+
+    // 两端都会修改的统计量
+    alignas(kCacheLine) std::atomic<size_t> bytes_{0};
+    std::atomic<int64_t> durationUs_{0};
+    std::atomic<uint64_t> totalPushed_{0};
+    std::atomic<uint64_t> blockedPushes_{0};
+
+    // 挂起/唤醒只在慢路径使用
+    alignas(kCacheLine) std::atomic<bool> consumerWaiting_{false};
+    std::atomic<bool> producerWaiting_{false};
+    std::atomic<bool> finished_{false};
+    std::mutex parkMutex_;
+    std::condition_variable condNotEmpty_;
+    std::condition_variable condNotFull_;
+
+    // 初始化后只读
+    alignas(kCacheLine) std::unique_ptr<T[]> slots_;
+    size_t capacity_;
+    size_t mask_;
+    QueueLimits limits_;
+    AVRational timeBase_ = {0, 1};
+};
+
+#endif // SPSC_QUEUE_H
@@ -5,17 +5,28 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 }
+#include "packetpool.h"
+#include "startuptrace.h"
+#include "playbackcontrol.h"
 
 struct AudioProcessingContext {
     // 解复用相关
     AVFormatContext* format_ctx = nullptr;
     int audio_stream_idx = -1;
     AVCodecParameters* codec_par = nullptr;
+    AVRational time_base = {0, 1};  // 音频流的时间基，解码出的 pts 以此为单位
 
     // 解码相关
     AVCodecContext* codec_ctx = nullptr;
     const AVCodec* codec = nullptr;
 
+    // AVPacket 回收池，由解复用和解码共享，不负责释放
+    PacketPool* packet_pool = nullptr;
+    // 启动阶段计时，不负责释放，可以为空
+    StartupTrace* startup_trace = nullptr;
+    // seek 等播放控制，不负责释放，可以为空
+    PlaybackControl* control = nullptr;
+
     // 状态控制
     bool demuxing_completed = false;
     bool decoding_completed = false;
@@ -2,8 +2,9 @@
 #define AUDIO_DECODER_H
 
 #include "audioContext.h"  // 引入音频处理上下文头文件
-#include "RingBuffer.h"  // 引入环形缓冲区头文件
-#include "queue.h"  // 添加包含 PacketQueue 定义的头文件
+#include "audioplayback.h"  // 环形缓冲区和音频时钟
+#include "SpscQueue.h"  // 解复用→解码的单生产者单消费者队列
+#include <vector>
 
 extern "C" {
 #include <libswresample/swresample.h>
@@ -12,11 +13,25 @@ extern "C" {
 class AudioDecoder {
 public:
     explicit AudioDecoder(AudioProcessingContext& ctx);
+    ~AudioDecoder();
     bool setupDecoder();
-    void decode(PacketQueue<AVPacket*>& packetQueue, RingBuffer<uint8_t>& ringBuffer);
+    void decode(SpscQueue<AVPacket*>& packetQueue, AudioPlaybackState& playback);
 private:
+    // 等待音频回调执行丢弃的最长时间
+    static constexpr int kDiscardTimeoutMs = 200;
+    // 到结尾后检查环形缓冲区是否播完的间隔
+    static constexpr int kDrainPollMs = 10;
+
+    void flushForSeek(AudioPlaybackState& playback, uint32_t serial);
+    void finishStream(AudioPlaybackState& playback, uint32_t serial);
+    // 精确 seek：丢掉目标之前的采样。整帧都在目标之前返回 false；
+    // 否则 input_ 指向从目标开始的采样，samples 和 ptsUs 更新为裁剪后的值
+    bool trimToSeekTarget(const AVFrame* frame, int* samples, int64_t* ptsUs);
+
     AudioProcessingContext& ctx_;
     SwrContext* swr_ctx_ = nullptr;
+    int64_t seekTargetUs_ = MasterClock::kNoTime;  // 精确 seek 的目标，没有进行中的精确 seek 时为 kNoTime
+    std::vector<const uint8_t*> input_;            // 交给 swr_convert 的每个声道（平面格式）的输入指针
 };
 
 #endif
\ No newline at end of file
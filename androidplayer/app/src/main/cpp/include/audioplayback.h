@@ -0,0 +1,31 @@
+#ifndef AUDIO_PLAYBACK_H
+#define AUDIO_PLAYBACK_H
+
+#include <atomic>
+#include <cstdint>
+#include "RingBuffer.h"  // 添加环形缓冲区头文件
+#include "mediaclock.h"
+
+// 音频解码线程与 AAudio 回调之间共享的状态，也是回调的用户数据。
+// 回调运行在实时线程中，只允许原子操作和内存拷贝，
+// 不加锁、不等待、不打印日志；数据不足时补静音并累加 underruns 计数。
+struct AudioPlaybackState {
+    RingBuffer<uint8_t>* ring = nullptr;
+    std::atomic<uint64_t> underruns{0};     // 数据不足、需要补静音的回调次数
+    std::atomic<uint64_t> silenceBytes{0};  // 累计补静音的字节数
+
+    // 音频时钟：环形缓冲区第一个字节对应的 pts（微秒），由解码线程在第一次写入前设置
+    MasterClock* clock = nullptr;
+    std::atomic<int64_t> basePtsUs{MasterClock::kNoTime};
+    // 回调已经从环形缓冲区取走的字节数（不含补的静音），只由回调线程修改
+    std::atomic<uint64_t> bytesConsumed{0};
+
+    // seek 之后的数据所属的序号。解码线程在 requestDiscard 之前写入，
+    // 回调执行丢弃后把它复制到 playingSerial（只由回调线程修改），用于标记音频时钟
+    std::atomic<uint32_t> serial{0};
+    uint32_t playingSerial = 0;
+
+    explicit AudioPlaybackState(RingBuffer<uint8_t>* r) : ring(r) {}
+};
+
+#endif
@@ -5,6 +5,11 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 }
+#include "packetpool.h"
+#include "startuptrace.h"
+#include "playbackcontrol.h"
+#include "fileio.h"
+#include <memory>
 
 struct VideoProcessingContext {
     // 解复用相关
@@ -24,6 +29,17 @@ struct VideoProcessingContext {
     AVCodecContext* audio_codec_ctx = nullptr;
     const AVCodec* audio_codec = nullptr;
 
+    // 本地文件的自定义 IO，format_ctx 使用 AVFMT_FLAG_CUSTOM_IO 时不会释放它。
+    // 成员在析构函数体之后才销毁，保证在 avformat_close_input 之后释放
+    std::unique_ptr<FileIO> file_io;
+
+    // AVPacket 回收池，由解复用和解码共享，不负责释放
+    PacketPool* packet_pool = nullptr;
+    // 启动阶段计时，不负责释放，可以为空
+    StartupTrace* startup_trace = nullptr;
+    // seek 等播放控制，不负责释放，可以为空
+    PlaybackControl* control = nullptr;
+
     // 状态控制
     bool demuxing_completed = false;
     bool decoding_completed = false;
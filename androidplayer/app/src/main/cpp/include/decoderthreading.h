@@ -0,0 +1,25 @@
+#ifndef DECODER_THREADING_H
+#define DECODER_THREADING_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 解码器线程策略：使用帧级还是片级多线程，以及线程个数
+struct DecoderThreading {
+    int threadType = 0;   // FF_THREAD_FRAME / FF_THREAD_SLICE，0 表示单线程
+    int threadCount = 1;
+    int onlineCores = 1;  // 选择策略时在线的 CPU 核数
+};
+
+// 根据解码器能力、在线核数和分辨率选择线程策略：
+// 支持帧级多线程的解码器（H.264/HEVC/VP9 等）优先使用帧级，否则使用片级；
+// 线程数随分辨率增加，不超过在线核数，并给解复用、音频和渲染线程留出一个核
+DecoderThreading chooseDecoderThreading(const AVCodec* codec, int width, int height);
+
+// 在 avcodec_open2 之前把策略写入解码器上下文
+void applyDecoderThreading(AVCodecContext* codecCtx, const DecoderThreading& threading);
+
+const char* decoderThreadTypeName(int threadType);
+
+#endif
@@ -2,22 +2,73 @@
 #define DEMUXER_H
 
 #include "context.h"
-#include "queue.h"
+#include "SpscQueue.h"
 #include "audioContext.h"
+#include "fileio.h"
+#include "keyframeindex.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+// 容器中一路流的概要信息，用于选择播放的音视频流
+struct StreamInfo {
+    int index = -1;
+    AVMediaType type = AVMEDIA_TYPE_UNKNOWN;
+    AVCodecID codecId = AV_CODEC_ID_NONE;
+    int64_t bitRate = 0;
+    std::string language;          // metadata 中的 language，可能为空
+    bool attachedPicture = false;  // 封面图
+    bool selected = false;         // 当前是否用于播放
+};
 
 class Demuxer {
 public:
     explicit Demuxer(VideoProcessingContext& ctx,AudioProcessingContext& audioctx);
     bool openInput(const char* url);
-    void start(PacketQueue<AVPacket*>& packetQueue);
+    void start(SpscQueue<AVPacket*>& packetQueue);
 
     // 新增方法声明
     bool openInputWithAudio(const char* url);
-    void startWithAudio(PacketQueue<AVPacket*>& videoPacketQueue, PacketQueue<AVPacket*>& audioPacketQueue);
+    void startWithAudio(SpscQueue<AVPacket*>& videoPacketQueue, SpscQueue<AVPacket*>& audioPacketQueue);
+
+    // 本地文件的读取方式，需在 openInput 之前设置，默认后台预读
+    void setFileIOMode(FileIOMode mode);
+
+    // 打开后容器中所有流的信息
+    std::vector<StreamInfo> streams() const;
+    // 选择用于播放的视频流或音频流，index 为 -1 时由 av_find_best_stream 自动选择。
+    // 其余流在解复用层被丢弃（AVDISCARD_ALL）。需在开始解复用、打开解码器之前调用
+    bool selectStream(AVMediaType type, int index = -1);
 
 private:
+    // 打开容器，format 不为空时跳过格式探测；失败后 format_ctx 会按需重新分配
+    bool openFormat(const char* url, const AVInputFormat* format);
+    bool pushPacket(AVPacket* pkt, SpscQueue<AVPacket*>& queue);
+    // 执行待处理的 seek，然后向每个包队列放入带新序号的标记包；audioQueue 可以为空
+    void serviceSeek(SpscQueue<AVPacket*>& videoQueue, SpscQueue<AVPacket*>* audioQueue);
+    // 定位到离 targetUs 最近的视频关键帧；精确 seek 时定位到不晚于 targetUs 的关键帧
+    bool seekToKeyframe(const SeekRequest& request);
+    void pushSeekMarker(const SeekRequest& request, SpscQueue<AVPacket*>& queue);
+    // 读到文件结尾时调用，返回 true 表示结束解复用。
+    // 有播放控制时放入结束标记包并等待：收到 seek 返回 false，播放结束（close）返回 true
+    bool finishAtEnd(SpscQueue<AVPacket*>& videoQueue, SpscQueue<AVPacket*>* audioQueue);
+    void pushEndMarker(SpscQueue<AVPacket*>& queue);
+    // 预览 seek 的关键帧已经送出时，等待下一个请求并返回 true
+    bool holdAfterPreview();
+    // 预览 seek 期间只放行第一个视频关键帧
+    bool acceptPacket(const AVPacket* pkt);
+    void markPhase(StartupPhase phase);
+    void applyStreamDiscard();
+    void reportPacketRate();
+
     VideoProcessingContext& ctx_;
     AudioProcessingContext& audio_ctx_;
+    std::chrono::steady_clock::time_point lastRateReport_;
+    PacketPoolStats lastPoolStats_;
+    FileIOMode fileIOMode_ = FileIOMode::ReadAhead;
+    KeyframeIndex keyframes_;  // 当前视频流的关键帧
+    bool previewing_ = false;    // 正在执行预览 seek
+    bool previewSent_ = false;   // 预览用的关键帧已经入队
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+#include <cstdint>
+#include <memory>
+
+struct FileIOStats {
+    uint64_t readCalls = 0;      // libavformat 调用 read 回调的次数
+    uint64_t bytesRead = 0;      // 交给 libavformat 的字节数
+    uint64_t seeks = 0;          // seek 回调次数（不含查询文件大小）
+    uint64_t syscallReads = 0;   // 实际调用 read()/pread() 的次数
+    uint64_t stalls = 0;         // 解复用线程因为数据未就绪而等待存储的次数
+    uint64_t windowResets = 0;   // seek 到缓存窗口之外、丢弃整个预读窗口的次数
+};
+
+// 本地文件的自定义 IO 方式
+enum class FileIOMode {
+    Default,    // 交给 libavformat 默认的 file 协议
+    Mapped,     // mmap 整个文件，见 MappedFileIO
+    ReadAhead,  // 后台线程预读，见 ReadAheadFileIO
+};
+
+// 为 libavformat 提供 AVIOContext 的本地文件读取方式。
+// AVIOContext 归实现类所有，必须在 avformat_close_input 之后才能释放。
+class FileIO {
+public:
+    virtual ~FileIO() = default;
+
+    // 打开文件并创建 AVIOContext，失败时返回 false
+    virtual bool open(const char* path) = 0;
+    virtual void close() = 0;
+    virtual AVIOContext* context() const = 0;
+    virtual FileIOStats stats() const = 0;
+
+    // 告知流的总码率（bit/s），用于调整预读量；默认忽略
+    virtual void setBitrate(int64_t /*bitsPerSecond*/) {}
+
+    // url 是否是可以用本地文件 IO 打开的路径（没有协议前缀，或 file: 协议），是则返回去掉前缀的路径
+    static const char* localPath(const char* url);
+
+    // 按方式创建实现，Default 返回 nullptr
+    static std::unique_ptr<FileIO> create(FileIOMode mode);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef FRAME_DROP_CONTROLLER_H
+#define FRAME_DROP_CONTROLLER_H
+
+#include <cstdint>
+
+// 解码跟不上时的降级档位，逐级加重
+enum class DropTier {
+    None,            // 正常解码
+    DropLate,        // 已经晚于丢弃阈值的帧在格式转换之前丢掉，不入帧队列
+    SkipLoopFilter,  // 再跳过环路滤波（skip_loop_filter），画质略降
+    SkipNonRef,      // 再整帧跳过非参考帧（skip_frame = AVDISCARD_NONREF）
+    KeyframeOnly,    // 只解码关键帧（skip_frame = AVDISCARD_NONKEY）
+};
+
+const char* dropTierName(DropTier tier);
+
+// 视频解码的降级控制：根据解码出的帧相对主时钟晚了多少决定档位。
+// 持续落后一段时间才降一级，持续跟上更长时间才升一级；
+// 升级后很快又落后说明设备撑不住上一档，下次升级需要等待的时间加倍，避免在两档之间来回切换。
+// 只在解码线程中使用，不加锁
+class FrameDropController {
+public:
+    // 记录一帧的延迟 lateUs（主时钟 - pts，正数表示落后），nowUs 为单调时钟。
+    // 档位变化时返回 true，变化前的档位写入 previous
+    bool update(int64_t lateUs, int64_t nowUs, DropTier* previous);
+    // 当前档位下这一帧是否应在转换之前丢弃
+    bool shouldDrop(int64_t lateUs) const;
+    // seek 之后时钟换了时间线，之前的观察不再有效；档位保留
+    void resetObservation();
+
+    DropTier tier() const { return tier_; }
+
+    // 超过这个延迟的帧渲染线程也会丢弃，与 VideoRender 的阈值一致
+    static constexpr int64_t kDropLateUs = 80000;
+
+private:
+    // 延迟超过这个值算落后
+    static constexpr int64_t kBehindUs = 40000;
+    // 解码出的帧至少不晚于显示时间才算跟上（帧队列里有缓冲时通常是负数）
+    static constexpr int64_t kCaughtUpUs = 0;
+    // 持续落后多久降一级
+    static constexpr int64_t kEscalateAfterUs = 300000;
+    // 持续跟上多久升一级，以及加倍的上限
+    static constexpr int64_t kRecoverAfterUs = 2000000;
+    static constexpr int64_t kMaxRecoverAfterUs = 32000000;
+    // 升级后这么短的时间内又降级，视为来回切换
+    static constexpr int64_t kOscillationUs = 5000000;
+    // 两次切换之间的最短间隔，让新档位的效果体现出来
+    static constexpr int64_t kMinHoldUs = 1000000;
+
+    static constexpr int64_t kUnset = INT64_MIN;
+
+    DropTier tier_ = DropTier::None;
+    int64_t behindSinceUs_ = kUnset;    // 开始持续落后的时刻
+    int64_t caughtUpSinceUs_ = kUnset;  // 开始持续跟上的时刻
+    int64_t lastChangeUs_ = kUnset;
+    int64_t lastRecoverUs_ = kUnset;
+    int64_t recoverAfterUs_ = kRecoverAfterUs;
+};
+
+#endif
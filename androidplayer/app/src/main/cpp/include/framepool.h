@@ -0,0 +1,60 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct FramePoolStats {
+    uint64_t acquires = 0;  // 取出的帧数
+    uint64_t rebuilds = 0;  // 因分辨率或格式变化重建池的次数
+    size_t bufferSize = 0;  // 当前每帧缓冲区的字节数
+};
+
+// 按分辨率分配视频帧的缓冲池，基于 AVBufferPool。
+// 同一分辨率和格式的帧共用一块预先计算好布局的对齐缓冲区，
+// 帧被 av_frame_free / av_frame_unref 后缓冲区自动回到池中，不再每帧分配大块内存。
+// 分辨率或格式变化时透明地重建池，旧池在所有帧归还后由 ffmpeg 释放。
+class FramePool {
+public:
+    // align 为 2 的幂，每个平面的起始地址和每行字节数都按它对齐
+    explicit FramePool(int align = 32);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // 取出一帧已经设置好 data/linesize 的帧，失败返回 nullptr
+    AVFrame* acquire(AVPixelFormat format, int width, int height);
+    // 给已有的帧分配缓冲区，只设置 buf/data/linesize/extended_data，不改动帧的格式和尺寸。
+    // 用于解码器的 get_buffer2，width/height 为对齐后的分配尺寸
+    bool fill(AVFrame* frame, AVPixelFormat format, int width, int height);
+
+    int align() const { return align_; }
+
+    FramePoolStats stats() const;
+
+private:
+    bool rebuildLocked(AVPixelFormat format, int width, int height);
+
+    mutable std::mutex mutex_;
+    AVBufferPool* pool_ = nullptr;
+    int align_;
+    AVPixelFormat format_ = AV_PIX_FMT_NONE;
+    int width_ = 0;
+    int height_ = 0;
+    int linesize_[4] = {0};
+    size_t planeOffset_[4] = {0};
+    size_t planeSize_[4] = {0};
+    size_t bufferSize_ = 0;
+    uint64_t acquires_ = 0;
+    uint64_t rebuilds_ = 0;
+};
+
+#endif
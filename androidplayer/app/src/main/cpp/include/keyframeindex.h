@@ -0,0 +1,55 @@
+#ifndef KEYFRAME_INDEX_H
+#define KEYFRAME_INDEX_H
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 一个关键帧的位置
+struct KeyframeEntry {
+    int64_t timestamp = AV_NOPTS_VALUE;  // 流时间基，优先使用 dts，与容器索引一致
+    int64_t pos = -1;                    // 在文件中的字节位置，未知为 -1
+    bool fromContainer = false;          // 来自容器索引
+    bool scannedSincePrev = false;       // 与前一个关键帧之间的数据已经完整读过，中间没有别的关键帧
+};
+
+// 视频流的关键帧索引，供 seek 查找离目标最近的关键帧。
+// 容器自带索引（MP4 sample table、读取过的 MKV cues 等）时直接导入；
+// 没有索引的格式（TS、裸流等）在解复用时记录读到的关键帧，之后在读过的范围内 seek 可以按字节位置直接定位，
+// 不必让 av_seek_frame 反复读文件二分查找时间戳。
+class KeyframeIndex {
+public:
+    // 导入 st 的容器索引，索引条目数没有变化时直接返回
+    void importFromStream(const AVStream* st);
+    // 解复用线程：读到一个视频包
+    void addPacket(const AVPacket* pkt);
+    // seek 之后调用：之后读到的关键帧与之前记录的不连续
+    void resetScan();
+
+    // 查找离 timestamp（流时间基）最近的关键帧。
+    // 惰性索引只在目标附近已完整读过、确定中间没有漏掉的关键帧时才返回结果
+    bool nearest(int64_t timestamp, KeyframeEntry* entry) const;
+    // 查找不晚于 timestamp 的最后一个关键帧，用于精确 seek
+    bool atOrBefore(int64_t timestamp, KeyframeEntry* entry) const;
+
+    size_t size() const;
+    bool hasContainerIndex() const;
+
+private:
+    bool findLocked(int64_t timestamp, bool allowAfter, KeyframeEntry* entry) const;
+
+    mutable std::mutex mutex_;
+    std::vector<KeyframeEntry> entries_;  // 按 timestamp 升序，不重复
+    int importedEntries_ = 0;             // 上次导入时容器索引的条目数
+    bool containerIndex_ = false;
+    // 当前连续读取的进度：最近的关键帧和读到的最大时间戳
+    int64_t scanKeyframe_ = AV_NOPTS_VALUE;
+    int64_t scanEnd_ = AV_NOPTS_VALUE;
+};
+
+#endif
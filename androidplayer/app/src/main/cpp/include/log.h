@@ -1,12 +1,69 @@
 #ifndef LOG_H
 #define LOG_H
 
-#include <android/log.h>
+#include <cstddef>
+#include <cstdint>
 
-#define LOGV(TAG, ...) __android_log_print(ANDROID_LOG_VERBOSE, TAG, __VA_ARGS__)
-#define LOGD(TAG, ...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
-#define LOGI(TAG, ...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
-#define LOGW(TAG, ...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
-#define LOGE(TAG, ...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+// 日志级别，数值与 android_LogPriority 一致
+#define PLAYER_LOG_LEVEL_VERBOSE 2
+#define PLAYER_LOG_LEVEL_DEBUG 3
+#define PLAYER_LOG_LEVEL_INFO 4
+#define PLAYER_LOG_LEVEL_WARN 5
+#define PLAYER_LOG_LEVEL_ERROR 6
+#define PLAYER_LOG_LEVEL_NONE 8
 
-#endif
\ No newline at end of file
+// 编译期日志级别，低于该级别的 LOGx 宏整体编译为空语句，参数也不会求值。
+// 可以在编译时通过 -DPLAYER_LOG_LEVEL=... 指定；默认 release 只保留 INFO 及以上，debug 保留 DEBUG 及以上
+#ifndef PLAYER_LOG_LEVEL
+#ifdef NDEBUG
+#define PLAYER_LOG_LEVEL PLAYER_LOG_LEVEL_INFO
+#else
+#define PLAYER_LOG_LEVEL PLAYER_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// 保留下来的日志不直接调用 __android_log_print，而是格式化后放入无锁环形队列，
+// 由后台线程统一写入 logcat，解码、渲染、音频回调等热路径上不会发生系统调用。
+// 后台线程未启动时（例如基准程序或启动早期）直接同步输出。
+namespace player_log {
+
+struct LogStats {
+    uint64_t written = 0;   // 已输出的条数
+    uint64_t dropped = 0;   // 队列满时丢弃的条数
+};
+
+// 启动后台输出线程，重复调用无副作用
+void start();
+// 输出队列中剩余的日志并停止后台线程，需在其他线程不再写日志之后调用
+void stop();
+// 把 ffmpeg 的 av_log 也接入同一个队列
+void installAvLogCallback();
+
+void write(int level, const char* tag, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+LogStats stats();
+
+// 作用域内启用异步输出，离开作用域时 stop
+class AsyncScope {
+public:
+    AsyncScope() { start(); }
+    ~AsyncScope() { stop(); }
+    AsyncScope(const AsyncScope&) = delete;
+    AsyncScope& operator=(const AsyncScope&) = delete;
+};
+
+}  // namespace player_log
+
+#define PLAYER_LOG_IF(LEVEL, TAG, ...)                      \
+    do {                                                    \
+        if ((LEVEL) >= PLAYER_LOG_LEVEL) {                  \
+            player_log::write((LEVEL), (TAG), __VA_ARGS__); \
+        }                                                   \
+    } while (0)
+
+#define LOGV(TAG, ...) PLAYER_LOG_IF(PLAYER_LOG_LEVEL_VERBOSE, TAG, __VA_ARGS__)
+#define LOGD(TAG, ...) PLAYER_LOG_IF(PLAYER_LOG_LEVEL_DEBUG, TAG, __VA_ARGS__)
+#define LOGI(TAG, ...) PLAYER_LOG_IF(PLAYER_LOG_LEVEL_INFO, TAG, __VA_ARGS__)
+#define LOGW(TAG, ...) PLAYER_LOG_IF(PLAYER_LOG_LEVEL_WARN, TAG, __VA_ARGS__)
+#define LOGE(TAG, ...) PLAYER_LOG_IF(PLAYER_LOG_LEVEL_ERROR, TAG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef MAPPED_FILE_IO_H
+#define MAPPED_FILE_IO_H
+
+#include "fileio.h"
+#include <cstddef>
+#include <cstdint>
+
+// 本地文件的自定义 AVIOContext。
+// 能 mmap 的普通文件整体映射为只读内存并提示 MADV_SEQUENTIAL，read 回调直接从映射区拷贝，不产生 read() 系统调用；
+// 不能映射的文件（管道、部分 FUSE 文件系统等）退回到按大块 read() 的缓冲读取。
+// 映射区的缺页仍然发生在解复用线程上，存储较慢时用 ReadAheadFileIO。
+class MappedFileIO : public FileIO {
+public:
+    MappedFileIO() = default;
+    ~MappedFileIO() override;
+
+    MappedFileIO(const MappedFileIO&) = delete;
+    MappedFileIO& operator=(const MappedFileIO&) = delete;
+
+    bool open(const char* path) override;
+    void close() override;
+
+    AVIOContext* context() const override { return avio_; }
+    FileIOStats stats() const override { return stats_; }
+    bool isMapped() const { return data_ != nullptr; }
+    int64_t size() const { return size_; }
+
+private:
+    static int readPacket(void* opaque, uint8_t* buf, int bufSize);
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+
+    int readMapped(uint8_t* buf, int bufSize);
+    int readBuffered(uint8_t* buf, int bufSize);
+
+    // AVIOContext 内部缓冲区大小。映射模式下只是一次 memcpy 的粒度，取大一些减少回调次数
+    static constexpr int kMappedBufferSize = 256 * 1024;
+    static constexpr int kBufferedBufferSize = 64 * 1024;
+
+    int fd_ = -1;
+    const uint8_t* data_ = nullptr;
+    int64_t size_ = -1;
+    int64_t pos_ = 0;
+    AVIOContext* avio_ = nullptr;
+    FileIOStats stats_;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MEDIA_CLOCK_H
+#define MEDIA_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+// 音视频同步的主时钟，时间单位为微秒，位于媒体时间线上（与 pts 换算后的值可直接比较）。
+// 有音频时以音频为准：AAudio 回调根据已经交给设备的采样数和设备内缓存的帧数计算当前正在播放的位置；
+// 音频不存在或停止更新时退回到单调系统时钟，并从最后一次音频时间平滑接续。
+// seek 之后时间线换成新的序号（见 PlaybackControl），序号不同的音频时间不再被采用。
+class MasterClock {
+public:
+    MasterClock() = default;
+
+    // 音频回调调用，实时线程中 wait-free。serial 为这段音频数据所属的序号
+    void setAudioTime(int64_t ptsUs, uint32_t serial = 0);
+
+    // 用第一帧视频的 pts 启动系统时钟，已经启动过则忽略
+    void startSystemClock(int64_t ptsUs);
+
+    // seek 后渲染线程显示新序号的第一帧时调用：系统时钟从 ptsUs 重新开始，
+    // 之后只采用同一序号的音频时间
+    void restart(int64_t ptsUs, uint32_t serial);
+
+    // 当前主时钟；时钟尚未启动时返回 kNoTime
+    int64_t nowUs();
+
+    // 最近是否有音频时钟更新
+    bool audioActive() const;
+
+    // 当前时间线的序号，seek 后在渲染线程显示新序号的第一帧时才切换
+    uint32_t serial() const { return serial_.load(std::memory_order_acquire); }
+
+    // 清空时钟，回到未启动状态。只能在音频回调不再调用 setAudioTime 时使用
+    void reset();
+
+    static int64_t monotonicUs();
+
+    static constexpr int64_t kNoTime = INT64_MIN;
+
+private:
+    // 超过这个时间没有音频更新就认为音频时钟失效
+    static constexpr int64_t kAudioStaleUs = 200000;
+    // 两次音频更新之间最多向前外推的时间
+    static constexpr int64_t kMaxExtrapolationUs = 100000;
+
+    bool readAudio(int64_t* ptsUs, int64_t* updatedUs) const;
+
+    // 顺序锁：写端只有音频回调一个线程，读端重试直到读到一致的两个值
+    std::atomic<uint32_t> audioSeq_{0};
+    std::atomic<int64_t> audioPtsUs_{kNoTime};
+    std::atomic<int64_t> audioUpdatedUs_{0};
+    std::atomic<uint32_t> audioSerial_{0};
+    // 当前时间线的序号
+    std::atomic<uint32_t> serial_{0};
+    // 系统时钟：媒体时间 = 单调时间 + 偏移
+    std::atomic<int64_t> systemOffsetUs_{kNoTime};
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef NULL_VIDEO_SINK_H
+#define NULL_VIDEO_SINK_H
+
+#include "videosink.h"
+#include <atomic>
+#include <cstdint>
+
+// 不显示的后端：只统计帧数和字节数，可选地对可见像素计算 Adler-32。
+// 用于在没有窗口的主机上测量解复用 + 解码 + 渲染调度的吞吐，校验和可以确认两次运行输出的画面一致
+class NullVideoSink : public IVideoSink {
+public:
+    explicit NullVideoSink(bool checksum = false);
+
+    bool init() override;
+    bool render(const AVFrame* frame) override;
+    const char* name() const override { return "Null"; }
+
+    uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+    // 可见区域的字节数，不含行尾的填充
+    uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+    // 所有帧按顺序累计的校验和，未开启时为 1
+    uint32_t checksum() const { return checksum_.load(std::memory_order_relaxed); }
+
+private:
+    const bool computeChecksum_;
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint32_t> checksum_{1};
+};
+
+#endif
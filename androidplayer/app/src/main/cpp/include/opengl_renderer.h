@@ -11,18 +11,27 @@
 #include <android/native_window.h>
 #include <iostream>
 #include <stdexcept>
+#include "yuvuploader.h"
+#include "videosink.h"
 
 extern "C" {
 #include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
 }
 
-class OpenGLRender {
+// GL 显示后端：YUV 三个平面上传为纹理，在着色器中转换为 RGB
+class OpenGLRender : public IVideoSink {
 public:
     OpenGLRender(ANativeWindow* window);
-    ~OpenGLRender();
+    ~OpenGLRender() override;
 
-    bool init();
-    bool renderFrame(AVFrame* frame);
+    bool init() override;
+    bool render(const AVFrame* frame) override;
+    void release() override;
+    const char* name() const override { return "GL"; }
+
+    // 可以直接上传为 Y/U/V 三个纹理的像素格式，以 AV_PIX_FMT_NONE 结尾
+    static const AVPixelFormat* supportedFormats();
 
 private:
     ANativeWindow* mNativeWindow;
@@ -30,9 +39,7 @@ private:
     EGLContext mEglContext;
     EGLSurface mEglSurface;
     GLuint mProgram;
-    GLuint mTextureY;
-    GLuint mTextureU;
-    GLuint mTextureV;
+    YuvTextureUploader mUploader;
     GLint mPositionHandle;
     GLint mTexCoordHandle;
     GLint mSamplerYHandle;
@@ -0,0 +1,106 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class PacketPool;
+
+// 只能移动的 AVPacket 句柄，析构时把 AVPacket 外壳还给池（没有池时直接释放）
+class PooledPacket {
+public:
+    PooledPacket() = default;
+    PooledPacket(PacketPool* pool, AVPacket* pkt) : pool_(pool), pkt_(pkt) {}
+    ~PooledPacket() { reset(); }
+
+    PooledPacket(PooledPacket&& other) noexcept : pool_(other.pool_), pkt_(other.pkt_) {
+        other.pkt_ = nullptr;
+    }
+
+    PooledPacket& operator=(PooledPacket&& other) noexcept {
+        if (this != &other) {
+            reset();
+            pool_ = other.pool_;
+            pkt_ = other.pkt_;
+            other.pkt_ = nullptr;
+        }
+        return *this;
+    }
+
+    PooledPacket(const PooledPacket&) = delete;
+    PooledPacket& operator=(const PooledPacket&) = delete;
+
+    AVPacket* get() const { return pkt_; }
+    AVPacket* operator->() const { return pkt_; }
+    explicit operator bool() const { return pkt_ != nullptr; }
+
+    // 交出所有权（例如放进队列），之后由接收方负责归还
+    AVPacket* release() {
+        AVPacket* pkt = pkt_;
+        pkt_ = nullptr;
+        return pkt;
+    }
+
+    // 归还给池
+    void reset();
+
+private:
+    PacketPool* pool_ = nullptr;
+    AVPacket* pkt_ = nullptr;
+};
+
+struct PacketPoolStats {
+    uint64_t allocations = 0;  // 调用 av_packet_alloc 的次数
+    uint64_t acquires = 0;     // 取出外壳的次数
+    uint64_t releases = 0;     // 归还的次数
+    size_t cached = 0;         // 池中空闲的外壳个数
+};
+
+// AVPacket 外壳回收池。解复用线程取出空外壳，用 av_packet_move_ref 把读到的数据移进去，
+// 解码线程用完后通过 PooledPacket 归还，避免每个包都 av_packet_clone / av_packet_free。
+// 取出和归还发生在不同线程，内部用一个短小的互斥锁保护空闲列表。
+class PacketPool {
+public:
+    explicit PacketPool(size_t maxCached = 512);
+    ~PacketPool();
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // 取出一个空的 AVPacket 外壳，池为空时才分配新的
+    PooledPacket acquire();
+    // 从 src 移动数据到回收的外壳中，src 变为空包
+    PooledPacket acquireMoved(AVPacket* src);
+    // 清空数据并放回池中，池已满时直接释放
+    void release(AVPacket* pkt);
+
+    PacketPoolStats stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<AVPacket*> free_;
+    size_t maxCached_;
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> acquires_{0};
+    std::atomic<uint64_t> releases_{0};
+};
+
+inline void PooledPacket::reset() {
+    if (!pkt_) {
+        return;
+    }
+    if (pool_) {
+        pool_->release(pkt_);
+    } else {
+        av_packet_free(&pkt_);
+    }
+    pkt_ = nullptr;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef PLAYBACK_CONTROL_H
+#define PLAYBACK_CONTROL_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// seek 方式
+enum class SeekMode {
+    Keyframe,  // 定位到离目标最近的关键帧，从关键帧开始显示
+    Accurate,  // 定位到目标之前的关键帧，目标之前的帧只解码不输出，音频裁剪到目标位置
+    Preview,   // 拖动进度条时的预览：只解码最近的一个关键帧并显示，不播放音频，之后暂停等待下一个请求
+};
+
+// 播放输出的两路，各自报告当前序号的数据是否已经播放到结尾
+enum class PlaybackStage {
+    Video,  // 渲染线程取到了结束标记帧
+    Audio,  // 音频解码线程排空了解码器，回调也已经播完环形缓冲区
+};
+
+// 一次 seek 请求
+struct SeekRequest {
+    uint32_t serial = 0;        // 请求对应的序号
+    SeekMode mode = SeekMode::Keyframe;
+    int64_t targetUs = 0;       // 媒体时间线上的目标位置（微秒，与 pts 换算后的值可直接比较）
+    int64_t requestedAtUs = 0;  // 发出请求的时刻（单调时钟）
+};
+
+// seek 统计，耗时为从发出请求到该序号的第一帧显示
+struct SeekStats {
+    uint64_t requested = 0;   // 收到的请求数
+    uint64_t performed = 0;   // 解复用线程实际执行的次数，被后来的请求覆盖的不计
+    uint64_t completed = 0;   // 显示出第一帧的次数
+    int64_t lastLatencyUs = 0;
+    int64_t maxLatencyUs = 0;
+    int64_t totalLatencyUs = 0;
+
+    double averageLatencyMs() const {
+        return completed > 0 ? totalLatencyUs / 1000.0 / completed : 0.0;
+    }
+};
+
+// 播放控制通道：JNI 线程发出 seek 请求，解复用线程执行，解码和渲染线程按序号丢弃过期的数据。
+// 每次请求把序号加一，在此之前入队的包、解码出的帧都属于旧序号。
+// 解码线程发现序号变化后直接丢弃取出的包，直到收到解复用线程 seek 之后放入的标记包，
+// 随后清空解码器，之后的帧都带上新的序号；渲染线程丢弃序号不是最新的帧。
+// 待执行的请求只保留最新的一个：拖动进度条时连续到来的请求在解复用线程取走之前互相覆盖，
+// 只有最新的目标会被执行。
+// 读到文件结尾时解复用线程不退出，放入结束标记包后停在 waitForSeek，结尾前几秒里的 seek 仍然有效；
+// 音视频都报告播放到结尾后，由播放线程（native-lib）调用 close 并结束各个队列。
+class PlaybackControl {
+public:
+    // 请求 seek 到 targetUs；解复用已经结束时返回 false
+    bool requestSeek(int64_t targetUs, SeekMode mode = SeekMode::Keyframe);
+    // 解复用线程：取出待执行的 seek
+    bool takeSeek(SeekRequest* request);
+    // 解复用线程：预览帧送出或读到结尾后在这里等待下一个请求，已关闭时返回 false
+    bool waitForSeek();
+    // 解码线程：收到标记包后查询 serial 对应的请求，serial 已经不是最新时返回 false
+    bool seekFor(uint32_t serial, SeekRequest* request) const;
+    bool seekPending() const;
+    // 解复用线程：seek 已执行完，elapsedUs 为定位耗时
+    void onSeekPerformed(const SeekRequest& request, int64_t elapsedUs);
+    // 渲染线程：serial 的第一帧已显示，记录 seek 到首帧的耗时
+    void onFirstFrame(uint32_t serial, int64_t ptsUs);
+
+    // stage 已经把 serial 的数据播放到结尾；serial 不是最新时忽略
+    void onEndOfStream(PlaybackStage stage, uint32_t serial);
+    // stage 的线程提前退出（例如音频输出打开失败），之后一直视为已经播放到结尾
+    void onStageStopped(PlaybackStage stage);
+    // 等待音视频都把最新序号的数据播放到结尾，且没有待执行的 seek。
+    // 返回之后仍可能收到新的请求，所以调用者要用 close 的结果确认
+    void waitForEnd();
+
+    // 最新的序号，数据的序号与它不同即为过期
+    uint32_t serial() const { return serial_.load(std::memory_order_acquire); }
+    bool isStale(uint32_t serial) const { return serial != this->serial(); }
+
+    // 播放结束时调用，之后的请求都被拒绝，等待中的解复用线程返回；还有待执行的 seek 时不关闭并返回 false
+    bool close();
+
+    SeekStats stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::atomic<uint32_t> serial_{0};
+    std::condition_variable seekReady_;
+    std::condition_variable endReady_;
+    bool pending_ = false;
+    bool closed_ = false;
+    SeekRequest latest_;  // 最新的请求，已执行后仍保留，用于计算首帧耗时
+    uint32_t completedSerial_ = 0;
+    SeekStats stats_;
+    // 每一路播放到结尾的序号，还没有到结尾时为 -1
+    int64_t endSerial_[2] = {-1, -1};
+    bool stageStopped_[2] = {false, false};
+
+    bool reachedEndLocked(PlaybackStage stage) const;
+};
+
+// 解复用线程在 seek 之后向每个包队列放入一个标记包，它不含数据，
+// stream_index 为 -1，pos 保存序号，pts 保存目标位置（微秒）
+void makeSeekMarker(AVPacket* pkt, const SeekRequest& request);
+bool isSeekMarker(const AVPacket* pkt);
+uint32_t seekMarkerSerial(const AVPacket* pkt);
+int64_t seekMarkerTargetUs(const AVPacket* pkt);
+
+// 解复用线程读到文件结尾时向每个包队列放入一个结束标记包：不含数据，stream_index 为 -2。
+// 解码线程收到后排空解码器，不退出
+void makeEndOfStreamMarker(AVPacket* pkt);
+bool isEndOfStreamMarker(const AVPacket* pkt);
+// 视频解码线程排空后向显示信箱写入一个不含数据的帧，序号照常通过 opaque 携带
+void makeEndOfStreamFrame(AVFrame* frame, uint32_t serial);
+bool isEndOfStreamFrame(const AVFrame* frame);
+
+// 解码出的帧通过 AVFrame::opaque 携带序号，av_frame_move_ref / av_frame_copy_props 会一起带过去
+void setFrameSerial(AVFrame* frame, uint32_t serial);
+uint32_t frameSerial(const AVFrame* frame);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PROBE_CACHE_H
+#define PROBE_CACHE_H
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 缓存中一路流的信息
+struct CachedStream {
+    struct ParametersDeleter {
+        void operator()(AVCodecParameters* par) const { avcodec_parameters_free(&par); }
+    };
+
+    std::unique_ptr<AVCodecParameters, ParametersDeleter> par;
+    AVRational timeBase = {0, 1};
+    AVRational avgFrameRate = {0, 1};
+    AVRational rFrameRate = {0, 1};
+};
+
+// 一个文件的探测结果
+struct ProbeCacheEntry {
+    std::string formatName;
+    int64_t duration = AV_NOPTS_VALUE;
+    int64_t bitRate = 0;
+    std::vector<CachedStream> streams;
+};
+
+// avformat_find_stream_info 结果的磁盘缓存，以 路径 + 文件大小 + 修改时间 为键。
+// 命中时直接指定容器格式、用很小的 probesize/analyzeduration 打开，再把缓存的编解码参数（含 extradata）写回各路流；
+// 打开后的流布局与缓存不一致时放弃缓存，恢复默认参数完整探测。
+class ProbeCache {
+public:
+    // 命中缓存时使用的探测参数
+    static constexpr int64_t kCachedProbeSize = 32 * 1024;
+    static constexpr int64_t kCachedAnalyzeDurationUs = 100000;
+
+    explicit ProbeCache(const std::string& directory);
+
+    bool enabled() const { return !directory_.empty(); }
+
+    // 查找 path 的缓存，文件大小或修改时间变化时视为未命中
+    bool lookup(const char* path, ProbeCacheEntry* entry) const;
+    // 把完整探测后的结果写入缓存
+    bool store(const char* path, const AVFormatContext* fmt) const;
+
+    // 校验 fmt 中的流布局与缓存一致后，把缓存的参数写回各路流。不一致时返回 false，fmt 不受影响
+    static bool restore(const ProbeCacheEntry& entry, AVFormatContext* fmt);
+
+    // 全局缓存目录，由 Java 层在启动时设置；为空表示不使用缓存
+    static void setDirectory(const std::string& directory);
+    static std::string directory();
+
+private:
+    std::string entryPath(const char* path) const;
+
+    std::string directory_;
+};
+
+#endif
@@ -8,22 +8,81 @@ extern "C" {
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <cstdint>
+
+// 队列容量策略，任一项为 0 表示该项不限制。
+// 只要有一项达到上限，push 就会阻塞，直到消费者取走数据或队列被标记为 finished。
+// 队列为空时总是允许放入一个元素，避免单个超大的包把生产者永久卡住。
+struct QueueLimits {
+    size_t maxPackets = 0;       // 最大元素个数
+    size_t maxBytes = 0;         // 最大负载字节数（AVPacket::size / AVFrame 缓冲区大小）
+    int64_t maxDurationUs = 0;   // 最大缓存时长（微秒），由 duration 和 time_base 换算
+};
+
+// 队列当前的统计信息，供解复用线程查询某一路流的缓存状态
+struct QueueStats {
+    size_t packets = 0;          // 当前元素个数
+    size_t bytes = 0;            // 当前负载字节数
+    int64_t durationUs = 0;      // 当前缓存时长（微秒）
+    uint64_t totalPushed = 0;    // 累计入队个数
+    uint64_t blockedPushes = 0;  // 因队列已满而阻塞过的 push 次数
+};
+
+// 计算队列元素的负载字节数和时长（以元素自身 time_base 为单位）
+inline size_t queueItemBytes(const AVPacket* pkt) {
+    return pkt ? static_cast<size_t>(pkt->size) : 0;
+}
+
+inline int64_t queueItemDuration(const AVPacket* pkt) {
+    return pkt ? pkt->duration : 0;
+}
+
+inline size_t queueItemBytes(const AVFrame* frame) {
+    size_t bytes = 0;
+    if (!frame) {
+        return 0;
+    }
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i]; i++) {
+        bytes += frame->buf[i]->size;
+    }
+    return bytes;
+}
+
+inline int64_t queueItemDuration(const AVFrame* frame) {
+    return frame ? frame->pkt_duration : 0;
+}
 
 template <typename T>
 class PacketQueue {
 public:
-    void push(T item);
+    explicit PacketQueue(const QueueLimits& limits = QueueLimits());
+
+    // 队列满时阻塞；如果在等待期间队列被标记为 finished，返回 false，元素仍归调用者所有
+    bool push(T item);
     T pop();
     void setFinished(bool finished);
     bool isFinished() const;
     size_t size() const; // 新增方法，用于获取队列大小
 
+    // 设置元素 duration 所使用的时间基，用于按时长限制队列
+    void setTimeBase(AVRational timeBase);
+    void setLimits(const QueueLimits& limits);
+    bool isFull() const;
+    QueueStats stats() const;
+
 private:
+    bool isFullLocked() const;
+
     std::queue<T> queue_;
     mutable std::mutex mutex_;
     std::condition_variable cond_;
+    std::condition_variable condNotFull_;
     bool finished_ = false;
     size_t size_ = 0; // 新增属性，记录队列大小
+
+    QueueLimits limits_;
+    AVRational timeBase_ = {0, 1};
+    QueueStats stats_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,70 @@
+#ifndef READ_AHEAD_FILE_IO_H
+#define READ_AHEAD_FILE_IO_H
+
+#include "fileio.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 后台预读的本地文件 IO。
+// 独立的读线程用 pread 按块读取解析位置之后的数据，放进一个环形窗口；libavformat 的 read 回调只从窗口拷贝，
+// 窗口里有数据时解复用线程不会碰到存储延迟（慢速 SD 卡、FUSE 路径）。
+// 窗口大小按码率换算成固定的预读时长；seek 落在窗口内时直接跳过，落在窗口外时丢弃整个窗口从新位置重新预读。
+class ReadAheadFileIO : public FileIO {
+public:
+    ReadAheadFileIO() = default;
+    ~ReadAheadFileIO() override;
+
+    ReadAheadFileIO(const ReadAheadFileIO&) = delete;
+    ReadAheadFileIO& operator=(const ReadAheadFileIO&) = delete;
+
+    bool open(const char* path) override;
+    void close() override;
+
+    AVIOContext* context() const override { return avio_; }
+    FileIOStats stats() const override;
+    // 预读窗口 = 码率 × kReadAheadSeconds，限制在 [kMinWindow, kMaxWindow]
+    void setBitrate(int64_t bitsPerSecond) override;
+
+    size_t windowSize() const;
+
+private:
+    static int readPacket(void* opaque, uint8_t* buf, int bufSize);
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+
+    void readerLoop();
+    // 把窗口容量调整为 size，保留已经读到的数据（放不下的部分丢弃），需持有 mutex_
+    void resizeWindowLocked(size_t size);
+    // 丢弃窗口，从 offset 重新预读，需持有 mutex_
+    void resetWindowLocked(int64_t offset);
+
+    static constexpr size_t kBlockSize = 256 * 1024;
+    static constexpr size_t kMinWindow = 2 * 1024 * 1024;
+    static constexpr size_t kMaxWindow = 32 * 1024 * 1024;
+    static constexpr size_t kDefaultWindow = 8 * 1024 * 1024;
+    static constexpr int64_t kReadAheadSeconds = 5;
+    static constexpr int kAvioBufferSize = 64 * 1024;
+
+    int fd_ = -1;
+    int64_t size_ = -1;
+    AVIOContext* avio_ = nullptr;
+    std::thread reader_;
+
+    // 以下成员由 mutex_ 保护。文件偏移 o 的数据存放在 window_[o % window_.size()]
+    mutable std::mutex mutex_;
+    std::condition_variable dataReady_;   // 读线程 → 解复用线程
+    std::condition_variable spaceReady_;  // 解复用线程 → 读线程
+    std::vector<uint8_t> window_;
+    int64_t windowStart_ = 0;   // 窗口中第一个字节的文件偏移，也就是当前解析位置
+    size_t windowBytes_ = 0;    // 窗口中已读到的字节数
+    uint64_t generation_ = 0;   // 每次丢弃窗口时递增，读线程据此丢弃过期的读取结果
+    bool eof_ = false;
+    int error_ = 0;
+    bool stopping_ = false;
+    FileIOStats stats_;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef STARTUP_TRACE_H
+#define STARTUP_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+// 启动阶段，按在时间线上出现的先后排列
+enum class StartupPhase {
+    Open = 0,        // avformat_open_input 完成
+    Probe,           // avformat_find_stream_info 完成
+    VideoCodecOpen,  // 视频解码器打开完成
+    AudioCodecOpen,  // 音频解码器打开完成
+    CodecOpen,       // 两个解码器都已就绪
+    FirstPacket,     // 第一个包入队
+    FirstFrame,      // 第一帧显示
+    Count
+};
+
+// 记录从开始播放到各个阶段完成的耗时。各阶段可能在不同线程标记，每个阶段只记录第一次
+class StartupTrace {
+public:
+    StartupTrace();
+
+    // 重新开始计时并清空所有阶段
+    void begin();
+    void mark(StartupPhase phase);
+    // 阶段完成时距开始的微秒数，尚未完成返回 -1
+    int64_t elapsedUs(StartupPhase phase) const;
+    // 输出所有阶段的耗时
+    void report() const;
+
+    static const char* phaseName(StartupPhase phase);
+
+private:
+    static int64_t nowUs();
+
+    std::atomic<int64_t> beginUs_{0};
+    std::atomic<int64_t> phaseUs_[static_cast<int>(StartupPhase::Count)];
+};
+
+#endif
@@ -1,20 +1,105 @@
 #ifndef VIDEO_DECODER_H
 #define VIDEO_DECODER_H
 
-#include <android/native_window.h>
 #include "context.h"
-#include "queue.h"
+#include "SpscQueue.h"
+#include "CircularBuffer.h"
+#include "framepool.h"
+#include "decoderthreading.h"
+#include "framedropcontroller.h"
+#include "mediaclock.h"
+#include <atomic>
+#include <chrono>
 extern "C" {
 #include <libswscale/swscale.h>
 }
+// 视频解码耗时统计，时间为调用 avcodec_send_packet / avcodec_receive_frame 的累计耗时
+struct VideoDecodeStats {
+    uint64_t frames = 0;
+    int64_t decodeTimeUs = 0;
+    uint64_t seekSkippedFrames = 0;  // 精确 seek 时只解码、没有输出的帧
+    uint64_t lateDroppedFrames = 0;  // 解码跟不上时在转换之前丢弃的晚到帧
+    uint64_t pooledBuffers = 0;      // 解码器通过 get_buffer2 从帧缓冲池取得的输出缓冲区
+    DropTier dropTier = DropTier::None;
+
+    double averageDecodeMs() const {
+        return frames > 0 ? decodeTimeUs / 1000.0 / frames : 0.0;
+    }
+};
+
 class VideoDecoder {
 public:
     explicit VideoDecoder(VideoProcessingContext& ctx);
+    ~VideoDecoder();
     bool setupDecoder();
-    void decode(PacketQueue<AVPacket*>& packetQueue,PacketQueue<AVFrame*>& frameQueue,ANativeWindow* window);
+    // 设置渲染器可以直接上传的像素格式（以 AV_PIX_FMT_NONE 结尾），
+    // 解码出的帧是其中之一时直接移交，否则用 sws_scale 转换为 YUV420P
+    void setOutputFormats(const AVPixelFormat* formats);
+    // 显示 Surface 的尺寸，需在 setupDecoder 之前设置。输出帧不超过这个尺寸：
+    // 解码器支持 lowres 时直接低分辨率解码，其余的缩小在 sws_scale 转换时一并完成。不设置则保持原尺寸
+    void setTargetSize(int width, int height);
+    void decode(SpscQueue<AVPacket*>& packetQueue,CircularBuffer& frameQueue);
+    // 与渲染线程共用的主时钟，用来判断解码是否跟得上；不设置则不做降级
+    void setClock(MasterClock* clock);
+
+    // 实际使用的线程策略和解码耗时，可在其他线程查询
+    const DecoderThreading& threading() const { return threading_; }
+    VideoDecodeStats decodeStats() const;
 private:
+    void addDecodeTime(std::chrono::steady_clock::time_point begin);
+    void reportDecodeStats(bool force);
+
+    // 精确 seek：收到标记包后记下目标位置，目标之前的帧只解码，不转换、不入队
+    void beginSeek(uint32_t serial);
+    bool beforeSeekTarget(int64_t pts, int64_t duration) const;
+    void finishSeek();
+
+    // 解码跟不上时的降级：根据帧相对主时钟的延迟调整档位，返回 true 表示这一帧在转换前丢弃
+    bool dropForLateness(const AVFrame* frame, uint32_t serial);
+    // 把当前档位写入解码器的 skip_frame / skip_loop_filter，pkt 为接下来要送入解码器的包。
+    // 从只解关键帧恢复时保持 AVDISCARD_NONKEY，直到 pkt 是关键帧
+    void applyDropTier(const AVPacket* pkt);
+
+    bool isOutputFormat(int format) const;
+    static bool isUploadable(const AVFrame* frame);
+    // 解码器的 get_buffer2：渲染器能直接上传的格式从 decoderPool_ 分配，其余交给 ffmpeg 默认的分配器
+    static int getBuffer(AVCodecContext* codecCtx, AVFrame* frame, int flags);
+    AVFrame* convertFrame(AVFrame* frame);
+    // 在 avcodec_open2 之前选择 lowres 等级
+    void chooseLowres();
+    // 帧缩小到 Surface 尺寸后的大小，不需要缩小时与原尺寸相同
+    void outputSize(int width, int height, int* outWidth, int* outHeight) const;
+
     VideoProcessingContext& ctx_;
     SwsContext* sws_ctx_ = nullptr;
+    int swsSrcFormat_ = AV_PIX_FMT_NONE;
+    int swsWidth_ = 0;
+    int swsHeight_ = 0;
+    int swsOutWidth_ = 0;
+    int swsOutHeight_ = 0;
+    int targetWidth_ = 0;   // Surface 尺寸，0 表示不限制
+    int targetHeight_ = 0;
+    const AVPixelFormat* outputFormats_;
+    FramePool framePool_;  // 转换后的帧从这里分配
+    FramePool decoderPool_;  // 解码器直接输出到这里，尺寸按解码器要求对齐，与转换用的池分开避免来回重建
+
+    DecoderThreading threading_;
+    std::atomic<uint64_t> decodedFrames_{0};
+    std::atomic<int64_t> decodeTimeUs_{0};
+    std::atomic<uint64_t> seekSkippedFrames_{0};
+    std::atomic<uint64_t> lateDroppedFrames_{0};
+    std::atomic<uint64_t> pooledBuffers_{0};
+    std::atomic<DropTier> dropTier_{DropTier::None};
+
+    MasterClock* clock_ = nullptr;
+    FrameDropController dropController_;
+    bool keyframeOnlyHeld_ = false;  // 已经按只解关键帧跳过了非关键帧，恢复要等到下一个关键帧
+
+    bool previewPending_ = false;  // 预览 seek：下一个包解码后立即取出画面
+    int64_t seekTarget_ = AV_NOPTS_VALUE;  // 精确 seek 的目标（流时间基），没有进行中的精确 seek 时为 AV_NOPTS_VALUE
+    uint64_t seekSkipped_ = 0;             // 本次 seek 跳过的帧数
+    std::chrono::steady_clock::time_point seekBegin_;
+    std::chrono::steady_clock::time_point lastStatsReport_;
 };
 
 #endif
\ No newline at end of file
@@ -2,41 +2,79 @@
 #ifndef VIDEORENDER_H
 #define VIDEORENDER_H
 
-#include <EGL/egl.h>
-#include <GLES2/gl2.h>
-#include <android/native_window.h>
-#include <android/native_window_jni.h>
-#include "queue.h"
+#include "CircularBuffer.h"
+#include "mediaclock.h"
+#include "startuptrace.h"
+#include "playbackcontrol.h"
+#include "videosink.h"
 #include <atomic>
+#include <cstdint>
 
 extern "C" {
 #include <libavutil/frame.h>
 }
 
+// 渲染线程的同步统计
+struct VideoRenderStats {
+    uint64_t rendered = 0;     // 实际显示的帧数
+    uint64_t dropped = 0;      // 因为太晚而丢弃的帧数
+    uint64_t late = 0;         // 晚于显示时间但仍在容忍范围内、照常显示的帧数
+    int64_t lastDriftUs = 0;   // 最近一帧的 显示时刻 - pts，正数表示视频落后
+    int64_t maxDriftUs = 0;    // 绝对值最大的漂移
+};
+
+// 渲染线程：从显示信箱取帧，按主时钟同步后交给显示后端（IVideoSink）。
+// 本身不涉及具体的显示方式，GL、ANativeWindow 和无输出的基准后端共用同一套同步和 seek 处理
 class VideoRender {
 public:
-    VideoRender(PacketQueue<AVFrame*>& frameQueue);
+    VideoRender(CircularBuffer& frameQueue);
     ~VideoRender();
 
-    bool Init(ANativeWindow* window);
-    void RenderLoop(ANativeWindow* window);
+    // 显示后端，需在 RenderLoop 之前设置，不负责释放；后端的 init 在 RenderLoop 所在的线程中调用
+    void setSink(IVideoSink* sink);
+    void RenderLoop();
     void Stop();
 
+    // 按 pts 同步显示需要的时间基和主时钟，需在 RenderLoop 之前设置；不设置时钟则不做同步
+    void setTimeBase(AVRational timeBase);
+    void setClock(MasterClock* clock);
+    // 第一帧显示时标记 FirstFrame 并输出启动耗时
+    void setStartupTrace(StartupTrace* trace);
+    // seek 后丢弃序号过期的帧，新序号的第一帧立即显示并记录 seek 耗时
+    void setPlaybackControl(PlaybackControl* control);
+    VideoRenderStats stats() const;
+
 private:
-    PacketQueue<AVFrame*>& frameQueue_;
-    ANativeWindow* window_;
-    EGLDisplay display_;
-    EGLSurface surface_;
-    EGLContext context_;
+    // 超过这个时间的帧直接丢弃
+    static constexpr int64_t kDropThresholdUs = 80000;
+    // 晚于这个时间但未到丢弃阈值的帧记为 late
+    static constexpr int64_t kLateThresholdUs = 20000;
+    // 等待显示时每次最多睡眠的时间，便于及时响应 Stop
+    static constexpr int64_t kMaxSleepUs = 20000;
+    // pts 比时钟超前太多（时间戳跳变）时不再等待
+    static constexpr int64_t kMaxWaitUs = 1000000;
+
+    int64_t framePtsUs(const AVFrame* frame) const;
+    // 等待直到 frame 的显示时间，返回 false 表示该帧应丢弃
+    bool waitForPresentation(const AVFrame* frame);
+    bool isStale(const AVFrame* frame) const;
+    void reportStats(bool force);
+
+    IVideoSink* sink_ = nullptr;
+    MasterClock* clock_ = nullptr;
+    StartupTrace* startupTrace_ = nullptr;
+    PlaybackControl* control_ = nullptr;
+    uint32_t shownSerial_ = 0;  // 最近显示的帧的序号
+    AVRational timeBase_ = {0, 1};
+    std::atomic<uint64_t> rendered_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> late_{0};
+    std::atomic<int64_t> lastDriftUs_{0};
+    std::atomic<int64_t> maxDriftUs_{0};
+    int64_t lastReportUs_ = 0;
+
+    CircularBuffer& frameQueue_;
     std::atomic<bool> running_;
-    GLuint program_;
-    GLuint positionHandle_;
-    GLuint textureHandle_;
-    GLuint textureId_[3];  // 用于存储Y、U、V三个纹理的ID
-
-    bool InitEGL();
-    bool InitShaders();
-    void DrawFrame(AVFrame* frame);
 };
 
 #endif // VIDEORENDER_H
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef VIDEO_SINK_H
+#define VIDEO_SINK_H
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 视频显示后端。VideoRender 负责取帧、音视频同步和 seek，只把确定要显示的帧交给后端。
+// 实现：OpenGLRender（GL 纹理）、ANWRender（转换为 RGBA 直接写入 ANativeWindow）、
+// NullVideoSink（不显示，只统计和计算校验和，用于在主机上跑基准）
+class IVideoSink {
+public:
+    virtual ~IVideoSink() = default;
+
+    // 在渲染线程中调用一次，之后的 render 都在同一个线程
+    virtual bool init() = 0;
+    // 显示一帧 YUV420P / YUVJ420P，返回后帧的数据不再被引用
+    virtual bool render(const AVFrame* frame) = 0;
+    // 渲染线程退出前调用，释放与线程绑定的资源（EGL 上下文等）
+    virtual void release() {}
+    virtual const char* name() const = 0;
+};
+
+#endif
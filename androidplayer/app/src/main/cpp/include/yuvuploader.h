@@ -0,0 +1,87 @@
+#ifndef YUV_UPLOADER_H
+#define YUV_UPLOADER_H
+
+#include <GLES3/gl3.h>
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 纹理上传方式
+enum class YuvUploadMode {
+    Direct,  // glTexSubImage2D 直接从帧的内存上传，驱动在调用返回前拷贝完数据
+    Pbo,     // 先拷贝到像素缓冲对象，再由 GPU 异步更新纹理，需要 ES3
+};
+
+struct YuvUploadStats {
+    uint64_t frames = 0;       // 上传的帧数
+    uint64_t allocations = 0;  // 分配纹理存储的次数（第一帧和分辨率变化时）
+    uint64_t rowWise = 0;      // 不支持 GL_UNPACK_ROW_LENGTH、逐行上传的平面数
+    uint64_t bytes = 0;        // 上传的像素字节数
+    uint64_t pboFrames = 0;    // 经过 PBO 上传的帧数
+    uint64_t fenceWaits = 0;   // 复用 PBO 时上一次的传输还没完成、需要等待的次数
+};
+
+// YUV420P 帧的纹理上传：Y/U/V 三个 GL_LUMINANCE 纹理只在分辨率变化时用 glTexImage2D 分配存储，
+// 之后每帧用 glTexSubImage2D 更新。带行填充（linesize > width）的帧：
+// ES3 或支持 GL_EXT_unpack_subimage 的上下文通过 GL_UNPACK_ROW_LENGTH 一次上传整个平面，
+// 只支持 ES2 时逐行上传，都不需要在 CPU 上先把数据拷贝成紧密排列。
+// Pbo 方式使用 kPboCount 个轮流使用的 PBO：帧数据拷贝进映射的 PBO 后，glTexSubImage2D 从 PBO 读取，
+// 调用立即返回，到纹理的搬运由 GPU 完成，渲染线程不必等驱动拷贝完三个平面。
+// 同一帧紧接着就采样这些纹理，GPU 上的传输要在这一帧的绘制之前完成，并不与上一帧的绘制重叠；
+// 能重叠的只有 CPU 写入下一个 PBO 与 GPU 处理上一帧。
+// 每个 PBO 在传输命令之后插入 fence，再次写入之前等它完成。上下文不是 ES3 时自动退回 Direct。
+// 所有调用都要在同一个 EGL 上下文所在的线程中进行。
+class YuvTextureUploader {
+public:
+    YuvTextureUploader() = default;
+    ~YuvTextureUploader();
+
+    YuvTextureUploader(const YuvTextureUploader&) = delete;
+    YuvTextureUploader& operator=(const YuvTextureUploader&) = delete;
+
+    // 创建纹理并检测上下文能力，需要当前线程已经绑定上下文
+    bool init(YuvUploadMode mode = YuvUploadMode::Direct);
+    // 上传一帧并把三个纹理依次绑定到 GL_TEXTURE0..2；没有 init 或帧无效时返回 false。
+    // 返回后帧的数据不再被引用，可以立即释放
+    bool upload(const AVFrame* frame);
+    // 释放纹理和 PBO，需要上下文仍然有效
+    void release();
+
+    YuvUploadMode mode() const { return mode_; }
+
+    // 基准程序用：强制按 ES2 的方式逐行上传
+    void setRowLengthEnabled(bool enabled) { useRowLength_ = enabled && rowLengthSupported_; }
+    bool rowLengthSupported() const { return rowLengthSupported_; }
+
+    const YuvUploadStats& stats() const { return stats_; }
+
+    static constexpr int kPboCount = 3;
+
+private:
+    struct PboSlot {
+        GLuint buffer = 0;
+        size_t size = 0;
+        GLsync fence = nullptr;
+    };
+
+    void ensureStorage(int plane, int width, int height);
+    void uploadPlane(const uint8_t* data, int linesize, int width, int height);
+    bool uploadThroughPbo(const AVFrame* frame, const int* widths, const int* heights);
+    // 等待 slot 上一次的传输完成，失败返回 false
+    bool waitForSlot(PboSlot& slot);
+
+    GLuint textures_[3] = {0, 0, 0};
+    int widths_[3] = {0, 0, 0};   // 已分配的纹理存储尺寸
+    int heights_[3] = {0, 0, 0};
+    bool rowLengthSupported_ = false;
+    bool useRowLength_ = false;
+    YuvUploadMode mode_ = YuvUploadMode::Direct;
+    PboSlot pbos_[kPboCount];
+    int nextPbo_ = 0;
+    YuvUploadStats stats_;
+};
+
+#endif
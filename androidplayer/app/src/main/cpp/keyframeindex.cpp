@@ -0,0 +1,159 @@
+#include "keyframeindex.h"
+#include <algorithm>
+
+namespace {
+
+bool earlier(const KeyframeEntry& a, int64_t timestamp) {
+    return a.timestamp < timestamp;
+}
+
+}  // namespace
+
+void KeyframeIndex::importFromStream(const AVStream* st) {
+    if (!st) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // MKV 等格式的索引可能在第一次 seek 时才读入，条目数变化时重新导入
+    if (st->nb_index_entries == importedEntries_) {
+        return;
+    }
+    importedEntries_ = st->nb_index_entries;
+
+    std::vector<KeyframeEntry> merged;
+    merged.reserve(entries_.size() + st->nb_index_entries);
+    for (int i = 0; i < st->nb_index_entries; i++) {
+        const AVIndexEntry& e = st->index_entries[i];
+        if (!(e.flags & AVINDEX_KEYFRAME)) {
+            continue;
+        }
+        KeyframeEntry entry;
+        entry.timestamp = e.timestamp;
+        entry.pos = e.pos;
+        entry.fromContainer = true;
+        entry.scannedSincePrev = true;
+        merged.push_back(entry);
+    }
+    if (merged.empty()) {
+        return;
+    }
+    containerIndex_ = true;
+
+    // 与已经扫描到的关键帧合并，同一时间戳只保留一项，优先保留容器索引的位置
+    merged.insert(merged.end(), entries_.begin(), entries_.end());
+    std::stable_sort(merged.begin(), merged.end(), [](const KeyframeEntry& a, const KeyframeEntry& b) {
+        if (a.timestamp != b.timestamp) {
+            return a.timestamp < b.timestamp;
+        }
+        return a.fromContainer && !b.fromContainer;
+    });
+    entries_.clear();
+    for (const KeyframeEntry& entry : merged) {
+        if (!entries_.empty() && entries_.back().timestamp == entry.timestamp) {
+            entries_.back().scannedSincePrev = entries_.back().scannedSincePrev || entry.scannedSincePrev;
+            continue;
+        }
+        entries_.push_back(entry);
+    }
+}
+
+void KeyframeIndex::addPacket(const AVPacket* pkt) {
+    const int64_t timestamp = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (timestamp == AV_NOPTS_VALUE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (containerIndex_) {
+        // 容器索引已经完整，不需要再记录
+        return;
+    }
+    if (scanKeyframe_ != AV_NOPTS_VALUE && timestamp > scanEnd_) {
+        scanEnd_ = timestamp;
+    }
+    if (!(pkt->flags & AV_PKT_FLAG_KEY)) {
+        return;
+    }
+
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), timestamp, earlier);
+    // 上一个关键帧也是这次连续读到的，两者之间就没有遗漏
+    const bool continuous = scanKeyframe_ != AV_NOPTS_VALUE && it != entries_.begin() &&
+                            (it - 1)->timestamp == scanKeyframe_;
+    if (it != entries_.end() && it->timestamp == timestamp) {
+        it->scannedSincePrev = it->scannedSincePrev || continuous;
+        if (it->pos < 0) {
+            it->pos = pkt->pos;
+        }
+    } else {
+        KeyframeEntry entry;
+        entry.timestamp = timestamp;
+        entry.pos = pkt->pos;
+        entry.scannedSincePrev = continuous;
+        entries_.insert(it, entry);
+    }
+    scanKeyframe_ = timestamp;
+    scanEnd_ = timestamp;
+}
+
+void KeyframeIndex::resetScan() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scanKeyframe_ = AV_NOPTS_VALUE;
+    scanEnd_ = AV_NOPTS_VALUE;
+}
+
+bool KeyframeIndex::nearest(int64_t timestamp, KeyframeEntry* entry) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findLocked(timestamp, true, entry);
+}
+
+bool KeyframeIndex::atOrBefore(int64_t timestamp, KeyframeEntry* entry) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findLocked(timestamp, false, entry);
+}
+
+bool KeyframeIndex::findLocked(int64_t timestamp, bool allowAfter, KeyframeEntry* entry) const {
+    if (entries_.empty()) {
+        return false;
+    }
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), timestamp, earlier);
+    if (it != entries_.end() && it->timestamp == timestamp) {
+        *entry = *it;
+        return true;
+    }
+    if (it == entries_.begin()) {
+        // 目标在第一个关键帧之前，只有完整的容器索引能确定它就是文件的第一个关键帧
+        if (!containerIndex_) {
+            return false;
+        }
+        *entry = *it;
+        return true;
+    }
+
+    const KeyframeEntry& before = *(it - 1);
+    if (it == entries_.end()) {
+        // 目标在最后一个已知关键帧之后：容器索引，或者当前正在连续读取且已经读过目标位置
+        const bool covered = containerIndex_ ||
+                             (scanKeyframe_ == before.timestamp && scanEnd_ >= timestamp);
+        if (!covered) {
+            return false;
+        }
+        *entry = before;
+        return true;
+    }
+
+    if (!containerIndex_ && !it->scannedSincePrev) {
+        return false;
+    }
+    const bool useBefore = !allowAfter || timestamp - before.timestamp <= it->timestamp - timestamp;
+    *entry = useBefore ? before : *it;
+    return true;
+}
+
+size_t KeyframeIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool KeyframeIndex::hasContainerIndex() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return containerIndex_;
+}
@@ -0,0 +1,225 @@
+#include "log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace player_log {
+namespace {
+
+constexpr size_t kSlotCount = 1024;   // 必须是 2 的幂
+constexpr size_t kTagSize = 32;
+constexpr size_t kMessageSize = 224;
+// 队列为空时后台线程的轮询间隔；生产者不主动唤醒，避免在热路径上做系统调用
+constexpr int kIdleSleepMs = 10;
+
+struct Slot {
+    std::atomic<size_t> sequence;
+    int level;
+    char tag[kTagSize];
+    char message[kMessageSize];
+};
+
+// 有界多生产者单消费者队列（Vyukov），每个槽位的 sequence 标记它当前可写还是可读。
+// 生产者用 CAS 抢占位置，队列满时直接丢弃，不会等待
+class LogRing {
+public:
+    LogRing() {
+        for (size_t i = 0; i < kSlotCount; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    Slot* beginPush() {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & (kSlotCount - 1)];
+            const size_t seq = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;  // 队列已满
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void commitPush(Slot* slot) {
+        const size_t pos = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // 只在后台线程调用
+    Slot* beginPop() {
+        Slot& slot = slots_[dequeuePos_ & (kSlotCount - 1)];
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq != dequeuePos_ + 1) {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    void commitPop(Slot* slot) {
+        slot->sequence.store(dequeuePos_ + kSlotCount, std::memory_order_release);
+        ++dequeuePos_;
+    }
+
+private:
+    Slot slots_[kSlotCount];
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_ = 0;
+};
+
+LogRing gRing;
+std::atomic<bool> gRunning{false};
+std::atomic<uint64_t> gWritten{0};
+std::atomic<uint64_t> gDropped{0};
+std::mutex gThreadMutex;
+std::thread gThread;
+
+void output(int level, const char* tag, const char* message) {
+#ifdef __ANDROID__
+    __android_log_write(level, tag, message);
+#else
+    static const char kLevels[] = "??VDIWEF";
+    const char c = (level >= 0 && level < 8) ? kLevels[level] : '?';
+    std::fprintf(stderr, "%c/%s: %s\n", c, tag, message);
+#endif
+    gWritten.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 返回本次输出的条数
+size_t drain() {
+    size_t count = 0;
+    while (Slot* slot = gRing.beginPop()) {
+        output(slot->level, slot->tag, slot->message);
+        gRing.commitPop(slot);
+        ++count;
+    }
+    return count;
+}
+
+void threadLoop() {
+    while (gRunning.load(std::memory_order_acquire)) {
+        if (drain() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kIdleSleepMs));
+        }
+    }
+    drain();
+}
+
+void vwrite(int level, const char* tag, const char* fmt, va_list args) {
+    if (!gRunning.load(std::memory_order_acquire)) {
+        char message[kMessageSize];
+        std::vsnprintf(message, sizeof(message), fmt, args);
+        output(level, tag, message);
+        return;
+    }
+    Slot* slot = gRing.beginPush();
+    if (!slot) {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot->level = level;
+    std::strncpy(slot->tag, tag ? tag : "", kTagSize - 1);
+    slot->tag[kTagSize - 1] = '\0';
+    std::vsnprintf(slot->message, kMessageSize, fmt, args);
+    gRing.commitPush(slot);
+}
+
+int avLevelToPriority(int level) {
+    if (level <= AV_LOG_ERROR) {
+        return PLAYER_LOG_LEVEL_ERROR;
+    }
+    if (level <= AV_LOG_WARNING) {
+        return PLAYER_LOG_LEVEL_WARN;
+    }
+    if (level <= AV_LOG_INFO) {
+        return PLAYER_LOG_LEVEL_INFO;
+    }
+    if (level <= AV_LOG_VERBOSE) {
+        return PLAYER_LOG_LEVEL_DEBUG;
+    }
+    return PLAYER_LOG_LEVEL_VERBOSE;
+}
+
+void avLogCallback(void* avcl, int level, const char* fmt, va_list args) {
+    if (level > av_log_get_level()) {
+        return;
+    }
+    const int priority = avLevelToPriority(level);
+    if (priority < PLAYER_LOG_LEVEL) {
+        return;
+    }
+    // av_log_format_line 需要保存前缀状态，ffmpeg 可能在多个线程同时输出，所以每个线程各自一份
+    thread_local int printPrefix = 1;
+    char line[kMessageSize];
+    av_log_format_line(avcl, level, fmt, args, line, sizeof(line), &printPrefix);
+    // ffmpeg 的日志行以换行结尾，logcat 不需要
+    size_t len = std::strlen(line);
+    while (len > 0 && line[len - 1] == '\n') {
+        line[--len] = '\0';
+    }
+    if (len > 0) {
+        write(priority, "ffmpeg", "%s", line);
+    }
+}
+
+}  // namespace
+
+void start() {
+    std::lock_guard<std::mutex> lock(gThreadMutex);
+    if (gRunning.load(std::memory_order_relaxed)) {
+        return;
+    }
+    gRunning.store(true, std::memory_order_release);
+    gThread = std::thread(threadLoop);
+}
+
+void stop() {
+    std::lock_guard<std::mutex> lock(gThreadMutex);
+    if (!gRunning.load(std::memory_order_relaxed)) {
+        return;
+    }
+    gRunning.store(false, std::memory_order_release);
+    gThread.join();
+    const uint64_t dropped = gDropped.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        char message[64];
+        std::snprintf(message, sizeof(message), "日志队列已满, 丢弃 %llu 条", (unsigned long long)dropped);
+        output(PLAYER_LOG_LEVEL_WARN, "player_log", message);
+    }
+}
+
+void installAvLogCallback() {
+    av_log_set_callback(avLogCallback);
+}
+
+void write(int level, const char* tag, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vwrite(level, tag, fmt, args);
+    va_end(args);
+}
+
+LogStats stats() {
+    LogStats stats;
+    stats.written = gWritten.load(std::memory_order_relaxed);
+    stats.dropped = gDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace player_log
@@ -0,0 +1,161 @@
+#include "mappedfileio.h"
+#include "log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/error.h>
+}
+
+#define TAG "MappedFileIO"
+
+MappedFileIO::~MappedFileIO() {
+    close();
+}
+
+bool MappedFileIO::open(const char* path) {
+    close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        LOGE(TAG, "打开文件失败: %s (%s)", path, std::strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && S_ISREG(st.st_mode)) {
+        size_ = st.st_size;
+    }
+    if (size_ > 0) {
+        void* addr = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (addr != MAP_FAILED) {
+            data_ = static_cast<const uint8_t*>(addr);
+            // 解复用基本是顺序读，让内核积极预读并及早回收读过的页
+            madvise(addr, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+        } else {
+            LOGW(TAG, "mmap 失败，改用缓冲读取: %s", std::strerror(errno));
+        }
+    }
+
+    const int bufferSize = data_ ? kMappedBufferSize : kBufferedBufferSize;
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(bufferSize));
+    if (!buffer) {
+        LOGE(TAG, "分配 AVIO 缓冲区失败");
+        close();
+        return false;
+    }
+    avio_ = avio_alloc_context(buffer, bufferSize, 0, this, readPacket, nullptr, seek);
+    if (!avio_) {
+        LOGE(TAG, "创建 AVIOContext 失败");
+        av_free(buffer);
+        close();
+        return false;
+    }
+    // 大小未知的文件（管道等）不支持 seek
+    if (size_ < 0) {
+        avio_->seekable = 0;
+    }
+
+    LOGI(TAG, "打开本地文件 %s, 大小 %lld 字节, %s", path, (long long)size_,
+         data_ ? "mmap" : "缓冲读取");
+    return true;
+}
+
+void MappedFileIO::close() {
+    if (avio_) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = -1;
+    pos_ = 0;
+}
+
+int MappedFileIO::readPacket(void* opaque, uint8_t* buf, int bufSize) {
+    MappedFileIO* self = static_cast<MappedFileIO*>(opaque);
+    const int n = self->data_ ? self->readMapped(buf, bufSize) : self->readBuffered(buf, bufSize);
+    if (n > 0) {
+        self->stats_.readCalls++;
+        self->stats_.bytesRead += n;
+    }
+    return n;
+}
+
+int MappedFileIO::readMapped(uint8_t* buf, int bufSize) {
+    if (pos_ >= size_) {
+        return AVERROR_EOF;
+    }
+    int64_t n = size_ - pos_;
+    if (n > bufSize) {
+        n = bufSize;
+    }
+    std::memcpy(buf, data_ + pos_, static_cast<size_t>(n));
+    pos_ += n;
+    return static_cast<int>(n);
+}
+
+int MappedFileIO::readBuffered(uint8_t* buf, int bufSize) {
+    for (;;) {
+        ssize_t n = ::read(fd_, buf, static_cast<size_t>(bufSize));
+        stats_.syscallReads++;
+        if (n > 0) {
+            pos_ += n;
+            return static_cast<int>(n);
+        }
+        if (n == 0) {
+            return AVERROR_EOF;
+        }
+        if (errno != EINTR) {
+            return AVERROR(errno);
+        }
+    }
+}
+
+int64_t MappedFileIO::seek(void* opaque, int64_t offset, int whence) {
+    MappedFileIO* self = static_cast<MappedFileIO*>(opaque);
+    if (whence == AVSEEK_SIZE) {
+        return self->size_ >= 0 ? self->size_ : AVERROR(ENOSYS);
+    }
+    whence &= ~AVSEEK_FORCE;
+
+    int64_t target;
+    switch (whence) {
+        case SEEK_SET:
+            target = offset;
+            break;
+        case SEEK_CUR:
+            target = self->pos_ + offset;
+            break;
+        case SEEK_END:
+            if (self->size_ < 0) {
+                return AVERROR(ENOSYS);
+            }
+            target = self->size_ + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
+    self->stats_.seeks++;
+
+    if (!self->data_) {
+        off_t result = lseek(self->fd_, static_cast<off_t>(target), SEEK_SET);
+        if (result < 0) {
+            return AVERROR(errno);
+        }
+    }
+    self->pos_ = target;
+    return target;
+}
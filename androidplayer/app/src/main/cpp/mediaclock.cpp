@@ -0,0 +1,84 @@
+#include "mediaclock.h"
+#include <time.h>
+
+int64_t MasterClock::monotonicUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void MasterClock::setAudioTime(int64_t ptsUs, uint32_t serial) {
+    uint32_t seq = audioSeq_.load(std::memory_order_relaxed);
+    audioSeq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    audioPtsUs_.store(ptsUs, std::memory_order_relaxed);
+    audioUpdatedUs_.store(monotonicUs(), std::memory_order_relaxed);
+    audioSerial_.store(serial, std::memory_order_relaxed);
+    audioSeq_.store(seq + 2, std::memory_order_release);
+}
+
+bool MasterClock::readAudio(int64_t* ptsUs, int64_t* updatedUs) const {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        uint32_t before = audioSeq_.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        int64_t pts = audioPtsUs_.load(std::memory_order_relaxed);
+        int64_t updated = audioUpdatedUs_.load(std::memory_order_relaxed);
+        uint32_t serial = audioSerial_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (audioSeq_.load(std::memory_order_relaxed) == before) {
+            *ptsUs = pts;
+            *updatedUs = updated;
+            // seek 之前的音频时间属于旧的时间线
+            return pts != kNoTime && serial == serial_.load(std::memory_order_acquire);
+        }
+    }
+    return false;
+}
+
+void MasterClock::startSystemClock(int64_t ptsUs) {
+    int64_t expected = kNoTime;
+    systemOffsetUs_.compare_exchange_strong(expected, ptsUs - monotonicUs());
+}
+
+void MasterClock::restart(int64_t ptsUs, uint32_t serial) {
+    serial_.store(serial, std::memory_order_release);
+    systemOffsetUs_.store(ptsUs - monotonicUs(), std::memory_order_relaxed);
+}
+
+int64_t MasterClock::nowUs() {
+    int64_t now = monotonicUs();
+    int64_t audioPts;
+    int64_t updated;
+    if (readAudio(&audioPts, &updated) && now - updated < kAudioStaleUs) {
+        int64_t elapsed = now - updated;
+        if (elapsed > kMaxExtrapolationUs) {
+            elapsed = kMaxExtrapolationUs;
+        }
+        int64_t clock = audioPts + elapsed;
+        // 让系统时钟跟随音频，音频中断时可以无缝切换
+        systemOffsetUs_.store(clock - now, std::memory_order_relaxed);
+        return clock;
+    }
+    int64_t offset = systemOffsetUs_.load(std::memory_order_relaxed);
+    if (offset == kNoTime) {
+        return kNoTime;
+    }
+    return now + offset;
+}
+
+bool MasterClock::audioActive() const {
+    int64_t audioPts;
+    int64_t updated;
+    return readAudio(&audioPts, &updated) && monotonicUs() - updated < kAudioStaleUs;
+}
+
+void MasterClock::reset() {
+    uint32_t seq = audioSeq_.load(std::memory_order_relaxed);
+    audioSeq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    audioPtsUs_.store(kNoTime, std::memory_order_relaxed);
+    audioSeq_.store(seq + 2, std::memory_order_release);
+    systemOffsetUs_.store(kNoTime, std::memory_order_relaxed);
+}
@@ -1,14 +1,17 @@
 #include <jni.h>
 #include "demuxer.h"
 #include "videodecoder.h"
-#include "queue.h"
+#include "SpscQueue.h"
 #include "videorender.h"
 #include "opengl_renderer.h"
 #include "audiodecoder.h"
 #include "AAudioRender.h"
 #include "RingBuffer.h"
+#include "probecache.h"
+#include "playbackcontrol.h"
+#include <mutex>
 #include <thread>
-#include <android/log.h>
+#include "log.h"
 #include <unistd.h>
 #include <sys/stat.h>
 #include <android/native_window.h>
@@ -16,34 +19,118 @@
 #define LOG_TAG "VideoProcessor"
 #include <iostream>
 
+namespace {
 
+// 正在播放的会话，Player 的 native 方法通过它控制播放。
+// processVideo 在启动线程前注册，所有线程结束后注销
+struct ActiveSession {
+    PlaybackControl* control = nullptr;
+    int64_t startUs = 0;     // 媒体时间线的起点
+    int64_t durationUs = 0;  // 总时长，未知为 0
+};
+
+std::mutex gSessionMutex;
+ActiveSession gSession;
+
+class SessionRegistration {
+public:
+    explicit SessionRegistration(const ActiveSession& session) {
+        std::lock_guard<std::mutex> lock(gSessionMutex);
+        gSession = session;
+    }
+
+    ~SessionRegistration() {
+        std::lock_guard<std::mutex> lock(gSessionMutex);
+        gSession = ActiveSession();
+    }
+};
+
+// position 为 0~1 之间的进度
+jint requestSeek(double position, SeekMode mode) {
+    std::lock_guard<std::mutex> lock(gSessionMutex);
+    if (!gSession.control || gSession.durationUs <= 0) {
+        LOGW(LOG_TAG, "没有正在播放的文件或时长未知，忽略 seek");
+        return -1;
+    }
+    if (position < 0) {
+        position = 0;
+    } else if (position > 1) {
+        position = 1;
+    }
+    const int64_t targetUs = gSession.startUs + static_cast<int64_t>(position * gSession.durationUs);
+    return gSession.control->requestSeek(targetUs, mode) ? 0 : -1;
+}
+
+}  // namespace
+
+// 定位到最近的关键帧
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_androidplayer_Player_nativeSeek(JNIEnv* env, jobject thiz, jdouble position) {
+    return requestSeek(position, SeekMode::Keyframe);
+}
+
+// 精确定位：从目标之前的关键帧解码到目标位置
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_androidplayer_Player_nativeSeekAccurate(JNIEnv* env, jobject thiz, jdouble position) {
+    return requestSeek(position, SeekMode::Accurate);
+}
+
+// 拖动进度条：只显示最近的关键帧，连续的请求只处理最新的一个，播放暂停在预览位置
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_androidplayer_Player_nativeScrubTo(JNIEnv* env, jobject thiz, jdouble position) {
+    return requestSeek(position, SeekMode::Preview);
+}
+
+// 松开进度条：精确定位到最终位置并恢复播放
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_androidplayer_Player_nativeScrubEnd(JNIEnv* env, jobject thiz, jdouble position) {
+    return requestSeek(position, SeekMode::Accurate);
+}
+
+// 设置应用缓存目录，用于保存探测结果等
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_androidplayer_MainActivity_nativeSetCacheDir(
+        JNIEnv* env, jobject thiz, jstring cache_dir) {
+    if (cache_dir == nullptr) {
+        return;
+    }
+    const char* dir = env->GetStringUTFChars(cache_dir, nullptr);
+    if (!dir) {
+        return;
+    }
+    ProbeCache::setDirectory(dir);
+    env->ReleaseStringUTFChars(cache_dir, dir);
+}
 
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_example_androidplayer_MainActivity_processVideo(
         JNIEnv* env, jobject thiz,
         jstring input_path, jstring output_path, jobject surface) {
+    // 日志交给后台线程输出，ffmpeg 内部日志也走同一个队列；函数返回前（所有线程已结束）输出剩余日志
+    player_log::AsyncScope asyncLog;
+    player_log::installAvLogCallback();
     if (surface == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Surface is null");
+        LOGE(LOG_TAG, "Surface is null");
         return JNI_FALSE;
     }
-    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Surface is  ok");
+    LOGI(LOG_TAG, "Surface is  ok");
     // 获取输入文件路径
     const char* input_path_str = env->GetStringUTFChars(input_path, nullptr);
     if (!input_path_str) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "获取输入路径失败");
+        LOGE(LOG_TAG, "获取输入路径失败");
         return JNI_FALSE;
     }
 
     // 1. 检查文件是否存在
     if (access(input_path_str, F_OK) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "文件不存在: %s", input_path_str);
+        LOGE(LOG_TAG, "文件不存在: %s", input_path_str);
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
 
     // 2. 检查文件是否可读
     if (access(input_path_str, R_OK) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "文件不可读: %s", input_path_str);
+        LOGE(LOG_TAG, "文件不可读: %s", input_path_str);
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
@@ -51,107 +138,180 @@ Java_com_example_androidplayer_MainActivity_processVideo(
     // 3. 检查文件大小
     struct stat file_stat;
     if (stat(input_path_str, &file_stat) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "获取文件信息失败: %s", input_path_str);
+        LOGE(LOG_TAG, "获取文件信息失败: %s", input_path_str);
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
 
     if (file_stat.st_size <= 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "文件大小为0: %s", input_path_str);
+        LOGE(LOG_TAG, "文件大小为0: %s", input_path_str);
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
 
-    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "文件检查通过: %s (大小: %lld字节)",
-                        input_path_str, (long long)file_stat.st_size);
-    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "获取文件: %s", input_path_str);
+    LOGI(LOG_TAG, "文件检查通过: %s (大小: %lld字节)",
+         input_path_str, (long long)file_stat.st_size);
+    LOGI(LOG_TAG, "获取文件: %s", input_path_str);
+    // 从这里开始统计启动各阶段的耗时
+    StartupTrace startupTrace;
     // 初始化上下文
     VideoProcessingContext ctx;
     AudioProcessingContext audioctx;
+    // 解复用和两个解码线程共享的 AVPacket 回收池
+    PacketPool packetPool;
+    ctx.packet_pool = &packetPool;
+    audioctx.packet_pool = &packetPool;
+    ctx.startup_trace = &startupTrace;
+    audioctx.startup_trace = &startupTrace;
+    // seek 请求从 JNI 线程经由它传给解复用、解码和渲染线程
+    PlaybackControl playbackControl;
+    ctx.control = &playbackControl;
+    audioctx.control = &playbackControl;
     // 设置解复用器
     Demuxer demuxer(ctx, audioctx);
     if (!demuxer.openInputWithAudio(input_path_str)) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "解复用器（包含音频）初始化失败");
+        LOGE(LOG_TAG, "解复用器（包含音频）初始化失败");
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
 
-    // 设置视频解码器
+    // 音视频解码器互不依赖，并行打开以缩短启动时间；每个解码器只在这里打开一次
+    AudioDecoder audioDecoder(audioctx);
+    bool audioReady = false;
+    std::thread audio_setup_thread([&] {
+        audioReady = audioDecoder.setupDecoder();
+    });
     VideoDecoder decoder(ctx);
-    if (!decoder.setupDecoder()) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "解码器初始化失败");
+    // 输出不超过 Surface 的尺寸，4K 片源播放到小窗口时在解码阶段就缩小
+    ANativeWindow* sizeWindow = ANativeWindow_fromSurface(env, surface);
+    if (sizeWindow) {
+        decoder.setTargetSize(ANativeWindow_getWidth(sizeWindow), ANativeWindow_getHeight(sizeWindow));
+        ANativeWindow_release(sizeWindow);
+    }
+    // 渲染器能直接上传的格式不经过 sws_scale
+    decoder.setOutputFormats(OpenGLRender::supportedFormats());
+    bool videoReady = decoder.setupDecoder();
+    audio_setup_thread.join();
+    if (!videoReady) {
+        LOGE(LOG_TAG, "解码器初始化失败");
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
-    // 设置音频解码器
-    AudioDecoder audioDecoder(audioctx);
-    if (!audioDecoder.setupDecoder()) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "音频解码器初始化失败");
+    if (!audioReady) {
+        LOGE(LOG_TAG, "音频解码器初始化失败");
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
+    startupTrace.mark(StartupPhase::CodecOpen);
 
     // 获取输出路径
     const char* output_path_str = env->GetStringUTFChars(output_path, nullptr);
     if (!output_path_str) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "获取输出路径失败");
+        LOGE(LOG_TAG, "获取输出路径失败");
         env->ReleaseStringUTFChars(input_path, input_path_str);
         return JNI_FALSE;
     }
 
     // 创建视频队列
-    PacketQueue<AVPacket*> packetQueue;
-    PacketQueue<AVFrame*> frameQueue;
-    PacketQueue<AVPacket*> packetQueue2;
+    // 队列有界，解复用线程在队列满时阻塞，避免把整个文件读进内存
+    QueueLimits videoPacketLimits;
+    videoPacketLimits.maxPackets = 600;
+    videoPacketLimits.maxBytes = 32 * 1024 * 1024;
+    videoPacketLimits.maxDurationUs = 5 * AV_TIME_BASE;
+    QueueLimits audioPacketLimits;
+    audioPacketLimits.maxPackets = 600;
+    audioPacketLimits.maxBytes = 4 * 1024 * 1024;
+    audioPacketLimits.maxDurationUs = 5 * AV_TIME_BASE;
+    // 每条链路都只有一个生产者和一个消费者，使用无锁的 SpscQueue
+    SpscQueue<AVPacket*> packetQueue(1024, videoPacketLimits);
+    // 解码后的帧很大（4K YUV420P 约 12MB），显示信箱只有固定的几个槽位，渲染卡住时覆盖最旧的帧
+    CircularBuffer frameQueue(4);
+    SpscQueue<AVPacket*> packetQueue2(1024, audioPacketLimits);
     // 创建音频队列
 
-    RingBuffer<uint8_t> ringBuffer(4096);
+    // 约 0.5 秒的 16 位交错 PCM，采样率和声道数取自解码器。
+    // 按整帧（声道数 × 2 字节）取整，回绕点才会落在帧边界上，7.1 声道的一帧是 16 字节
+    const size_t audioBytesPerFrame = static_cast<size_t>(audioctx.codec_ctx->channels) * 2;
+    const size_t audioRingFrames = static_cast<size_t>(audioctx.codec_ctx->sample_rate) / 2;
+    RingBuffer<uint8_t> ringBuffer(audioRingFrames * audioBytesPerFrame);
+    // 音视频同步的主时钟：音频回调更新，渲染线程读取
+    MasterClock masterClock;
+    AudioPlaybackState audioState(&ringBuffer);
+    audioState.clock = &masterClock;
     // 创建视频渲染器
     VideoRender videoRender(frameQueue);
+    videoRender.setTimeBase(ctx.format_ctx->streams[ctx.video_stream_idx]->time_base);
+    videoRender.setClock(&masterClock);
+    decoder.setClock(&masterClock);
+    videoRender.setStartupTrace(&startupTrace);
+    videoRender.setPlaybackControl(&playbackControl);
 
     // 初始化 VideoRender
     ANativeWindow* window = ANativeWindow_fromSurface(env, surface);
     if (!window) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "获取 Surface 失败");
+        LOGE(LOG_TAG, "获取 Surface 失败");
         env->ReleaseStringUTFChars(input_path, input_path_str);
         env->ReleaseStringUTFChars(output_path, output_path_str);
         return JNI_FALSE;
     }
+    // GL 显示后端，EGL 上下文在渲染线程中创建
+    OpenGLRender glSink(window);
+    videoRender.setSink(&glSink);
     // 初始化音频渲染器
     // 创建 AAudioRender 实例
     AAudioRender audioRender;
-    audioRender.setCallback(AAudioRender::myAudioCallback, &ringBuffer);
-    audioRender.configure(44100, 2, AAUDIO_FORMAT_PCM_I16);
+    audioRender.setCallback(AAudioRender::myAudioCallback, &audioState);
+    // 采样率和声道数与解码输出保持一致，音频时钟按这个采样率换算
+    audioRender.configure(audioctx.codec_ctx->sample_rate, audioctx.codec_ctx->channels, AAUDIO_FORMAT_PCM_I16);
+
+    if (audioRender.start() != 0) {
+        // 没有消费者，避免音频解码线程在写环形缓冲区时一直等待
+        LOGE(LOG_TAG, "音频输出启动失败");
+        ringBuffer.close();
+    }
+    ActiveSession session;
+    session.control = &playbackControl;
+    session.startUs = ctx.format_ctx->start_time != AV_NOPTS_VALUE ? ctx.format_ctx->start_time : 0;
+    session.durationUs = ctx.format_ctx->duration != AV_NOPTS_VALUE ? ctx.format_ctx->duration : 0;
+    SessionRegistration registration(session);
 
-    audioRender.start();
     // 启动线程
     // 解复用线程
     std::thread demux_thread([&] {
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "开始解复用线程");
+        LOGI(LOG_TAG, "开始解复用线程");
         demuxer.startWithAudio(packetQueue, packetQueue2);
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "解复用线程完成");
+        LOGI(LOG_TAG, "解复用线程完成");
     });
     // 视频解码线程
     // 视频渲染线程
     std::thread render_thread([&] {
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "开始渲染线程");
-        videoRender.RenderLoop(window);
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "渲染线程完成");
+        LOGI(LOG_TAG, "开始渲染线程");
+        videoRender.RenderLoop();
+        LOGI(LOG_TAG, "渲染线程完成");
     });
     std::thread decode_thread([&] {
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "开始解码线程");
-        decoder.decode(packetQueue, frameQueue, window);
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "解码线程完成");
+        LOGI(LOG_TAG, "开始解码线程");
+        decoder.decode(packetQueue, frameQueue);
+        LOGI(LOG_TAG, "解码线程完成");
     });
     // 音频解码线程
 
     std::thread audio_decode_thread([&] {
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "开始音频解码线程");
-        audioDecoder.decode(packetQueue2, ringBuffer);
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "解码音频线程完成");
+        LOGI(LOG_TAG, "开始音频解码线程");
+        audioDecoder.decode(packetQueue2, audioState);
+        LOGI(LOG_TAG, "解码音频线程完成");
     });
 
 
+    // 等待音视频都播放到结尾。解复用线程读到结尾后不退出，结尾前几秒里仍然可以 seek；
+    // close 时还有待执行的 seek 说明又开始播放了，继续等
+    do {
+        playbackControl.waitForEnd();
+    } while (!playbackControl.close());
+    // 播放真正结束后才结束包队列，解码线程排空后退出，解复用线程从等待中返回
+    packetQueue.setFinished(true);
+    packetQueue2.setFinished(true);
+
     // 等待完成
     audio_decode_thread.join();
     demux_thread.join();
@@ -160,7 +320,21 @@ Java_com_example_androidplayer_MainActivity_processVideo(
     render_thread.join();
 
 
-    __android_log_print(ANDROID_LOG_INFO, "PacketQueue", "外部: %zu", packetQueue2.size());
+    LOGI("PacketQueue", "外部: %zu", packetQueue2.size());
+    LOGI(LOG_TAG, "音频欠载 %llu 次, 共补静音 %llu 字节",
+         (unsigned long long)audioState.underruns.load(),
+         (unsigned long long)audioState.silenceBytes.load());
+    VideoRenderStats renderStats = videoRender.stats();
+    CircularBufferStats mailboxStats = frameQueue.stats();
+    LOGI(LOG_TAG, "视频显示 %llu 帧, 丢弃 %llu 帧, 晚到 %llu 帧, 渲染卡住时覆盖 %llu 帧",
+         (unsigned long long)renderStats.rendered, (unsigned long long)renderStats.dropped,
+         (unsigned long long)renderStats.late, (unsigned long long)mailboxStats.overwritten);
+    SeekStats seekStats = playbackControl.stats();
+    if (seekStats.requested > 0) {
+        LOGI(LOG_TAG, "seek 请求 %llu 次, 执行 %llu 次, 首帧耗时 平均 %.1fms 最大 %.1fms",
+             (unsigned long long)seekStats.requested, (unsigned long long)seekStats.performed,
+             seekStats.averageLatencyMs(), seekStats.maxLatencyUs / 1000.0);
+    }
     // 释放资源
     ANativeWindow_release(window);
     env->ReleaseStringUTFChars(input_path, input_path_str);
@@ -168,8 +342,8 @@ Java_com_example_androidplayer_MainActivity_processVideo(
 
     // 验证结果
     bool success = (ctx.demuxing_completed && ctx.decoding_completed);
-    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "处理完成: %s",
-                        success? "成功" : "失败");
+    LOGI(LOG_TAG, "处理完成: %s",
+         success? "成功" : "失败");
 
     return success? JNI_TRUE : JNI_FALSE;
 }
\ No newline at end of file
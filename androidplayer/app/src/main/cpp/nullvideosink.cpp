@@ -0,0 +1,48 @@
+#include "nullvideosink.h"
+#include "log.h"
+
+extern "C" {
+#include <libavutil/adler32.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#define TAG "NullVideoSink"
+
+NullVideoSink::NullVideoSink(bool checksum) : computeChecksum_(checksum) {}
+
+bool NullVideoSink::init() {
+    return true;
+}
+
+bool NullVideoSink::render(const AVFrame* frame) {
+    if (!frame) {
+        return false;
+    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+    if (!desc) {
+        LOGE(TAG, "未知的像素格式 %d", frame->format);
+        return false;
+    }
+    // 每个平面可见部分一行的字节数，不含对齐填充
+    int rowBytes[4];
+    if (av_image_fill_linesizes(rowBytes, (AVPixelFormat)frame->format, frame->width) < 0) {
+        return false;
+    }
+    uint64_t bytes = 0;
+    uint32_t sum = checksum_.load(std::memory_order_relaxed);
+    for (int i = 0; i < 4 && frame->data[i]; i++) {
+        const bool chroma = i == 1 || i == 2;
+        const int planeHeight = chroma ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        bytes += (uint64_t)rowBytes[i] * planeHeight;
+        if (computeChecksum_) {
+            for (int y = 0; y < planeHeight; y++) {
+                sum = av_adler32_update(sum, frame->data[i] + (ptrdiff_t)y * frame->linesize[i], rowBytes[i]);
+            }
+        }
+    }
+    checksum_.store(sum, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
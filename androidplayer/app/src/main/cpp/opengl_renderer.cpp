@@ -1,5 +1,6 @@
 #include "opengl_renderer.h"
-#include <android/log.h>
+#include "log.h"
+#include <EGL/eglext.h>
 
 // 顶点着色器代码
 const char* vertexShaderSource =
@@ -31,38 +32,47 @@ const char* fragmentShaderSource =
         "}\n";
 
 #define LOG_TAG "OpenGLRender"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 OpenGLRender::OpenGLRender(ANativeWindow* window)
         : mNativeWindow(window), mEglDisplay(EGL_NO_DISPLAY), mEglContext(EGL_NO_CONTEXT), mEglSurface(EGL_NO_SURFACE),
-          mProgram(0), mTextureY(0), mTextureU(0), mTextureV(0) {}
+          mProgram(0) {}
 
 OpenGLRender::~OpenGLRender() {
+    release();
+}
+
+void OpenGLRender::release() {
     if (mEglDisplay != EGL_NO_DISPLAY) {
+        // 纹理和着色器程序要在上下文销毁之前释放
+        mUploader.release();
+        if (mProgram != 0) {
+            glDeleteProgram(mProgram);
+            mProgram = 0;
+        }
         eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         if (mEglContext != EGL_NO_CONTEXT) {
             eglDestroyContext(mEglDisplay, mEglContext);
+            mEglContext = EGL_NO_CONTEXT;
         }
         if (mEglSurface != EGL_NO_SURFACE) {
             eglDestroySurface(mEglDisplay, mEglSurface);
+            mEglSurface = EGL_NO_SURFACE;
         }
         eglTerminate(mEglDisplay);
-    }
-    if (mProgram != 0) {
-        glDeleteProgram(mProgram);
-    }
-    if (mTextureY != 0) {
-        glDeleteTextures(1, &mTextureY);
-    }
-    if (mTextureU != 0) {
-        glDeleteTextures(1, &mTextureU);
-    }
-    if (mTextureV != 0) {
-        glDeleteTextures(1, &mTextureV);
+        mEglDisplay = EGL_NO_DISPLAY;
     }
 }
 
+const AVPixelFormat* OpenGLRender::supportedFormats() {
+    // 三个平面、色度宽高各减半的 8 位 YUV
+    static const AVPixelFormat formats[] = {
+            AV_PIX_FMT_YUV420P,
+            AV_PIX_FMT_YUVJ420P,
+            AV_PIX_FMT_NONE
+    };
+    return formats;
+}
+
 bool OpenGLRender::init() {
     if (!initEGL()) {
         return false;
@@ -79,52 +89,56 @@ bool OpenGLRender::init() {
 bool OpenGLRender::initEGL() {
     mEglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     if (mEglDisplay == EGL_NO_DISPLAY) {
-        LOGE("Failed to get EGL display");
+        LOGE(LOG_TAG, "Failed to get EGL display");
         return false;
     }
 
     EGLint majorVersion, minorVersion;
     if (!eglInitialize(mEglDisplay, &majorVersion, &minorVersion)) {
-        LOGE("Failed to initialize EGL");
+        LOGE(LOG_TAG, "Failed to initialize EGL");
         return false;
     }
 
-    const EGLint configAttribs[] = {
-            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-            EGL_RED_SIZE, 8,
-            EGL_GREEN_SIZE, 8,
-            EGL_BLUE_SIZE, 8,
-            EGL_ALPHA_SIZE, 8,
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-            EGL_NONE
-    };
-
-    EGLConfig eglConfig;
-    EGLint numConfigs;
-    if (!eglChooseConfig(mEglDisplay, configAttribs, &eglConfig, 1, &numConfigs)) {
-        LOGE("Failed to choose EGL config");
+    // 优先创建 ES3 上下文以使用 PBO 上传，不支持时退回 ES2。
+    // ES3 上下文要用带 EGL_OPENGL_ES3_BIT_KHR 的配置创建，严格的实现在 ES2 配置上会返回 EGL_BAD_CONFIG
+    EGLConfig eglConfig = nullptr;
+    for (EGLint version : {3, 2}) {
+        const EGLint configAttribs[] = {
+                EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+                EGL_RED_SIZE, 8,
+                EGL_GREEN_SIZE, 8,
+                EGL_BLUE_SIZE, 8,
+                EGL_ALPHA_SIZE, 8,
+                EGL_RENDERABLE_TYPE, version == 3 ? EGL_OPENGL_ES3_BIT_KHR : EGL_OPENGL_ES2_BIT,
+                EGL_NONE
+        };
+        EGLint numConfigs = 0;
+        if (!eglChooseConfig(mEglDisplay, configAttribs, &eglConfig, 1, &numConfigs) || numConfigs < 1) {
+            continue;
+        }
+        const EGLint contextAttribs[] = {
+                EGL_CONTEXT_CLIENT_VERSION, version,
+                EGL_NONE
+        };
+        mEglContext = eglCreateContext(mEglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttribs);
+        if (mEglContext != EGL_NO_CONTEXT) {
+            LOGI(LOG_TAG, "EGL context: ES%d", version);
+            break;
+        }
+    }
+    if (mEglContext == EGL_NO_CONTEXT) {
+        LOGE(LOG_TAG, "Failed to create EGL context");
         return false;
     }
 
     mEglSurface = eglCreateWindowSurface(mEglDisplay, eglConfig, mNativeWindow, nullptr);
     if (mEglSurface == EGL_NO_SURFACE) {
-        LOGE("Failed to create EGL surface");
-        return false;
-    }
-
-    const EGLint contextAttribs[] = {
-            EGL_CONTEXT_CLIENT_VERSION, 2,
-            EGL_NONE
-    };
-
-    mEglContext = eglCreateContext(mEglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttribs);
-    if (mEglContext == EGL_NO_CONTEXT) {
-        LOGE("Failed to create EGL context");
+        LOGE(LOG_TAG, "Failed to create EGL surface");
         return false;
     }
 
     if (!eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface, mEglContext)) {
-        LOGE("Failed to make EGL context current");
+        LOGE(LOG_TAG, "Failed to make EGL context current");
         return false;
     }
 
@@ -139,7 +153,7 @@ bool OpenGLRender::initShaders() {
     GLint compiled;
     glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &compiled);
     if (!compiled) {
-        LOGE("Failed to compile vertex shader");
+        LOGE(LOG_TAG, "Failed to compile vertex shader");
         glDeleteShader(vertexShader);
         return false;
     }
@@ -150,7 +164,7 @@ bool OpenGLRender::initShaders() {
 
     glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &compiled);
     if (!compiled) {
-        LOGE("Failed to compile fragment shader");
+        LOGE(LOG_TAG, "Failed to compile fragment shader");
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
         return false;
@@ -164,7 +178,7 @@ bool OpenGLRender::initShaders() {
     GLint linked;
     glGetProgramiv(mProgram, GL_LINK_STATUS, &linked);
     if (!linked) {
-        LOGE("Failed to link shader program");
+        LOGE(LOG_TAG, "Failed to link shader program");
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
         glDeleteProgram(mProgram);
@@ -184,49 +198,21 @@ bool OpenGLRender::initShaders() {
 }
 
 bool OpenGLRender::initTextures() {
-    glGenTextures(1, &mTextureY);
-    glBindTexture(GL_TEXTURE_2D, mTextureY);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glGenTextures(1, &mTextureU);
-    glBindTexture(GL_TEXTURE_2D, mTextureU);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glGenTextures(1, &mTextureV);
-    glBindTexture(GL_TEXTURE_2D, mTextureV);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    return true;
+    // ES3 上下文使用 PBO：渲染线程只做一次内存拷贝，不等驱动拷贝三个平面；否则直接上传
+    return mUploader.init(YuvUploadMode::Pbo);
 }
 
-bool OpenGLRender::renderFrame(AVFrame* frame) {
+bool OpenGLRender::render(const AVFrame* frame) {
     if (!frame) {
         return false;
     }
 
     glUseProgram(mProgram);
 
-    // 更新纹理数据
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mTextureY);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame->width, frame->height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, frame->data[0]);
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, mTextureU);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame->width / 2, frame->height / 2, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, frame->data[1]);
-
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, mTextureV);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame->width / 2, frame->height / 2, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, frame->data[2]);
+    // 更新纹理数据，Y/U/V 依次绑定到纹理单元 0/1/2
+    if (!mUploader.upload(frame)) {
+        return false;
+    }
 
     // 设置纹理采样器
     glUniform1i(mSamplerYHandle, 0);
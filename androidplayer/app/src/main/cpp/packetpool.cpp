@@ -0,0 +1,61 @@
+#include "packetpool.h"
+
+PacketPool::PacketPool(size_t maxCached) : maxCached_(maxCached) {
+    free_.reserve(maxCached);
+}
+
+PacketPool::~PacketPool() {
+    for (AVPacket* pkt : free_) {
+        av_packet_free(&pkt);
+    }
+    free_.clear();
+}
+
+PooledPacket PacketPool::acquire() {
+    acquires_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            AVPacket* pkt = free_.back();
+            free_.pop_back();
+            return PooledPacket(this, pkt);
+        }
+    }
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    return PooledPacket(this, av_packet_alloc());
+}
+
+PooledPacket PacketPool::acquireMoved(AVPacket* src) {
+    PooledPacket pkt = acquire();
+    if (pkt) {
+        av_packet_move_ref(pkt.get(), src);
+    }
+    return pkt;
+}
+
+void PacketPool::release(AVPacket* pkt) {
+    if (!pkt) {
+        return;
+    }
+    releases_.fetch_add(1, std::memory_order_relaxed);
+    // 在锁外释放负载，锁内只操作空闲列表
+    av_packet_unref(pkt);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < maxCached_) {
+            free_.push_back(pkt);
+            return;
+        }
+    }
+    av_packet_free(&pkt);
+}
+
+PacketPoolStats PacketPool::stats() const {
+    PacketPoolStats stats;
+    stats.allocations = allocations_.load(std::memory_order_relaxed);
+    stats.acquires = acquires_.load(std::memory_order_relaxed);
+    stats.releases = releases_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.cached = free_.size();
+    return stats;
+}
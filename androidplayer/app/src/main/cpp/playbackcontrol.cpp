@@ -0,0 +1,182 @@
+#include "playbackcontrol.h"
+#include "mediaclock.h"
+#include "log.h"
+
+#define TAG "PlaybackControl"
+
+namespace {
+constexpr int kSeekMarkerStream = -1;
+constexpr int kEndOfStreamStream = -2;
+
+int stageIndex(PlaybackStage stage) {
+    return stage == PlaybackStage::Video ? 0 : 1;
+}
+}
+
+bool PlaybackControl::requestSeek(int64_t targetUs, SeekMode mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+        return false;
+    }
+    // 先换序号，解码线程立即开始丢弃队列里的旧数据，解复用线程不会一直卡在满队列上
+    latest_.serial = serial_.load(std::memory_order_relaxed) + 1;
+    latest_.targetUs = targetUs;
+    latest_.mode = mode;
+    latest_.requestedAtUs = MasterClock::monotonicUs();
+    serial_.store(latest_.serial, std::memory_order_release);
+    pending_ = true;
+    stats_.requested++;
+    seekReady_.notify_one();
+    LOGD(TAG, "seek 请求 #%u: %.3fs%s", latest_.serial, targetUs / 1000000.0,
+         mode == SeekMode::Accurate ? " (精确)" : mode == SeekMode::Preview ? " (预览)" : "");
+    return true;
+}
+
+bool PlaybackControl::waitForSeek() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    seekReady_.wait(lock, [this] { return pending_ || closed_; });
+    return pending_;
+}
+
+bool PlaybackControl::takeSeek(SeekRequest* request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_) {
+        return false;
+    }
+    *request = latest_;
+    pending_ = false;
+    return true;
+}
+
+bool PlaybackControl::seekFor(uint32_t serial, SeekRequest* request) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (serial != latest_.serial) {
+        return false;
+    }
+    *request = latest_;
+    return true;
+}
+
+bool PlaybackControl::seekPending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+void PlaybackControl::onSeekPerformed(const SeekRequest& request, int64_t elapsedUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.performed++;
+    LOGI(TAG, "执行 seek #%u 到 %.3fs, 定位耗时 %.1fms (累计请求 %llu 次)",
+         request.serial, request.targetUs / 1000000.0, elapsedUs / 1000.0,
+         (unsigned long long)stats_.requested);
+}
+
+void PlaybackControl::onFirstFrame(uint32_t serial, int64_t ptsUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (serial != latest_.serial || serial == completedSerial_) {
+        return;
+    }
+    completedSerial_ = serial;
+    const int64_t latencyUs = MasterClock::monotonicUs() - latest_.requestedAtUs;
+    stats_.completed++;
+    stats_.lastLatencyUs = latencyUs;
+    stats_.totalLatencyUs += latencyUs;
+    if (latencyUs > stats_.maxLatencyUs) {
+        stats_.maxLatencyUs = latencyUs;
+    }
+    LOGI(TAG, "seek #%u 首帧 %.3fs (目标 %.3fs), 耗时 %.1fms, 平均 %.1fms",
+         serial, ptsUs / 1000000.0, latest_.targetUs / 1000000.0, latencyUs / 1000.0,
+         stats_.averageLatencyMs());
+}
+
+void PlaybackControl::onEndOfStream(PlaybackStage stage, uint32_t serial) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (serial != serial_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    endSerial_[stageIndex(stage)] = serial;
+    LOGI(TAG, "%s播放到结尾 (#%u)", stage == PlaybackStage::Video ? "视频" : "音频", serial);
+    endReady_.notify_all();
+}
+
+void PlaybackControl::onStageStopped(PlaybackStage stage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stageStopped_[stageIndex(stage)] = true;
+    endReady_.notify_all();
+}
+
+bool PlaybackControl::reachedEndLocked(PlaybackStage stage) const {
+    const int index = stageIndex(stage);
+    return stageStopped_[index] || endSerial_[index] == serial_.load(std::memory_order_relaxed);
+}
+
+void PlaybackControl::waitForEnd() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // seek 会换序号，之前的结尾状态随之失效
+    endReady_.wait(lock, [this] {
+        return closed_ || (!pending_ && reachedEndLocked(PlaybackStage::Video) &&
+                           reachedEndLocked(PlaybackStage::Audio));
+    });
+}
+
+bool PlaybackControl::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_) {
+        return false;
+    }
+    closed_ = true;
+    seekReady_.notify_all();
+    endReady_.notify_all();
+    return true;
+}
+
+SeekStats PlaybackControl::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void makeSeekMarker(AVPacket* pkt, const SeekRequest& request) {
+    av_packet_unref(pkt);
+    pkt->stream_index = kSeekMarkerStream;
+    pkt->pos = request.serial;
+    pkt->pts = request.targetUs;
+    pkt->dts = request.targetUs;
+}
+
+bool isSeekMarker(const AVPacket* pkt) {
+    return pkt && pkt->stream_index == kSeekMarkerStream && pkt->size == 0;
+}
+
+uint32_t seekMarkerSerial(const AVPacket* pkt) {
+    return static_cast<uint32_t>(pkt->pos);
+}
+
+int64_t seekMarkerTargetUs(const AVPacket* pkt) {
+    return pkt->pts;
+}
+
+void makeEndOfStreamMarker(AVPacket* pkt) {
+    av_packet_unref(pkt);
+    pkt->stream_index = kEndOfStreamStream;
+}
+
+bool isEndOfStreamMarker(const AVPacket* pkt) {
+    return pkt && pkt->stream_index == kEndOfStreamStream && pkt->size == 0;
+}
+
+void makeEndOfStreamFrame(AVFrame* frame, uint32_t serial) {
+    av_frame_unref(frame);
+    setFrameSerial(frame, serial);
+}
+
+bool isEndOfStreamFrame(const AVFrame* frame) {
+    // 解码输出的帧总有数据缓冲区
+    return frame && !frame->data[0];
+}
+
+void setFrameSerial(AVFrame* frame, uint32_t serial) {
+    frame->opaque = reinterpret_cast<void*>(static_cast<uintptr_t>(serial));
+}
+
+uint32_t frameSerial(const AVFrame* frame) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(frame->opaque));
+}
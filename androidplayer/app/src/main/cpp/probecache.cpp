@@ -0,0 +1,325 @@
+#include "probecache.h"
+#include "log.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sys/stat.h>
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+#define TAG "ProbeCache"
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43505041;  // "APPC"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kMaxStreams = 64;
+constexpr uint32_t kMaxExtradata = 16 * 1024 * 1024;
+constexpr uint32_t kMaxString = 4096;
+
+std::mutex gDirectoryMutex;
+std::string gDirectory;
+
+// 定长字段的简单二进制读写，缓存只在本机使用，不考虑字节序
+class Writer {
+public:
+    explicit Writer(FILE* file) : file_(file) {}
+
+    template <typename T>
+    void put(T value) {
+        ok_ = ok_ && std::fwrite(&value, sizeof(value), 1, file_) == 1;
+    }
+
+    void putBytes(const void* data, uint32_t size) {
+        put(size);
+        ok_ = ok_ && (size == 0 || std::fwrite(data, size, 1, file_) == 1);
+    }
+
+    void putString(const std::string& s) {
+        putBytes(s.data(), static_cast<uint32_t>(s.size()));
+    }
+
+    void putRational(AVRational r) {
+        put<int32_t>(r.num);
+        put<int32_t>(r.den);
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    FILE* file_;
+    bool ok_ = true;
+};
+
+class Reader {
+public:
+    explicit Reader(FILE* file) : file_(file) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        ok_ = ok_ && std::fread(&value, sizeof(value), 1, file_) == 1;
+        return value;
+    }
+
+    std::string getString() {
+        const uint32_t size = get<uint32_t>();
+        if (!ok_ || size > kMaxString) {
+            ok_ = false;
+            return std::string();
+        }
+        std::string s(size, '\0');
+        ok_ = size == 0 || std::fread(&s[0], size, 1, file_) == 1;
+        return s;
+    }
+
+    AVRational getRational() {
+        AVRational r;
+        r.num = get<int32_t>();
+        r.den = get<int32_t>();
+        return r;
+    }
+
+    bool ok() const { return ok_; }
+    void fail() { ok_ = false; }
+    FILE* file() const { return file_; }
+
+private:
+    FILE* file_;
+    bool ok_ = true;
+};
+
+bool statFile(const char* path, int64_t* size, int64_t* mtime) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    *size = st.st_size;
+    *mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+void writeParameters(Writer& w, const AVCodecParameters* par) {
+    w.put<int32_t>(par->codec_type);
+    w.put<int32_t>(par->codec_id);
+    w.put<uint32_t>(par->codec_tag);
+    w.putBytes(par->extradata, par->extradata ? static_cast<uint32_t>(par->extradata_size) : 0);
+    w.put<int32_t>(par->format);
+    w.put<int64_t>(par->bit_rate);
+    w.put<int32_t>(par->bits_per_coded_sample);
+    w.put<int32_t>(par->bits_per_raw_sample);
+    w.put<int32_t>(par->profile);
+    w.put<int32_t>(par->level);
+    w.put<int32_t>(par->width);
+    w.put<int32_t>(par->height);
+    w.putRational(par->sample_aspect_ratio);
+    w.put<int32_t>(par->field_order);
+    w.put<int32_t>(par->color_range);
+    w.put<int32_t>(par->color_primaries);
+    w.put<int32_t>(par->color_trc);
+    w.put<int32_t>(par->color_space);
+    w.put<int32_t>(par->chroma_location);
+    w.put<int32_t>(par->video_delay);
+    w.put<uint64_t>(par->channel_layout);
+    w.put<int32_t>(par->channels);
+    w.put<int32_t>(par->sample_rate);
+    w.put<int32_t>(par->block_align);
+    w.put<int32_t>(par->frame_size);
+    w.put<int32_t>(par->initial_padding);
+    w.put<int32_t>(par->trailing_padding);
+    w.put<int32_t>(par->seek_preroll);
+}
+
+bool readParameters(Reader& r, AVCodecParameters* par) {
+    par->codec_type = static_cast<AVMediaType>(r.get<int32_t>());
+    par->codec_id = static_cast<AVCodecID>(r.get<int32_t>());
+    par->codec_tag = r.get<uint32_t>();
+    const uint32_t extradataSize = r.get<uint32_t>();
+    if (!r.ok() || extradataSize > kMaxExtradata) {
+        return false;
+    }
+    if (extradataSize > 0) {
+        par->extradata = static_cast<uint8_t*>(av_mallocz(extradataSize + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (!par->extradata) {
+            return false;
+        }
+        par->extradata_size = static_cast<int>(extradataSize);
+        if (std::fread(par->extradata, extradataSize, 1, r.file()) != 1) {
+            return false;
+        }
+    }
+    par->format = r.get<int32_t>();
+    par->bit_rate = r.get<int64_t>();
+    par->bits_per_coded_sample = r.get<int32_t>();
+    par->bits_per_raw_sample = r.get<int32_t>();
+    par->profile = r.get<int32_t>();
+    par->level = r.get<int32_t>();
+    par->width = r.get<int32_t>();
+    par->height = r.get<int32_t>();
+    par->sample_aspect_ratio = r.getRational();
+    par->field_order = static_cast<AVFieldOrder>(r.get<int32_t>());
+    par->color_range = static_cast<AVColorRange>(r.get<int32_t>());
+    par->color_primaries = static_cast<AVColorPrimaries>(r.get<int32_t>());
+    par->color_trc = static_cast<AVColorTransferCharacteristic>(r.get<int32_t>());
+    par->color_space = static_cast<AVColorSpace>(r.get<int32_t>());
+    par->chroma_location = static_cast<AVChromaLocation>(r.get<int32_t>());
+    par->video_delay = r.get<int32_t>();
+    par->channel_layout = r.get<uint64_t>();
+    par->channels = r.get<int32_t>();
+    par->sample_rate = r.get<int32_t>();
+    par->block_align = r.get<int32_t>();
+    par->frame_size = r.get<int32_t>();
+    par->initial_padding = r.get<int32_t>();
+    par->trailing_padding = r.get<int32_t>();
+    par->seek_preroll = r.get<int32_t>();
+    return r.ok();
+}
+
+}  // namespace
+
+ProbeCache::ProbeCache(const std::string& directory) : directory_(directory) {}
+
+void ProbeCache::setDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(gDirectoryMutex);
+    gDirectory = directory;
+}
+
+std::string ProbeCache::directory() {
+    std::lock_guard<std::mutex> lock(gDirectoryMutex);
+    return gDirectory;
+}
+
+std::string ProbeCache::entryPath(const char* path) const {
+    // 路径的 FNV-1a 哈希作为文件名，完整路径存在缓存文件里再比较一次
+    uint64_t hash = 1469598103934665603ULL;
+    for (const char* p = path; *p; p++) {
+        hash ^= static_cast<uint8_t>(*p);
+        hash *= 1099511628211ULL;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.probe", (unsigned long long)hash);
+    return directory_ + "/" + name;
+}
+
+bool ProbeCache::lookup(const char* path, ProbeCacheEntry* entry) const {
+    int64_t size = 0;
+    int64_t mtime = 0;
+    if (!enabled() || !statFile(path, &size, &mtime)) {
+        return false;
+    }
+    FILE* file = std::fopen(entryPath(path).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    Reader r(file);
+    bool ok = r.get<uint32_t>() == kMagic && r.get<uint32_t>() == kVersion;
+    ok = ok && r.getString() == path;
+    ok = ok && r.get<int64_t>() == size && r.get<int64_t>() == mtime;
+    if (ok) {
+        entry->formatName = r.getString();
+        entry->duration = r.get<int64_t>();
+        entry->bitRate = r.get<int64_t>();
+        const uint32_t count = r.get<uint32_t>();
+        ok = r.ok() && count > 0 && count <= kMaxStreams;
+        entry->streams.clear();
+        for (uint32_t i = 0; ok && i < count; i++) {
+            CachedStream stream;
+            stream.par.reset(avcodec_parameters_alloc());
+            ok = stream.par && readParameters(r, stream.par.get());
+            stream.timeBase = r.getRational();
+            stream.avgFrameRate = r.getRational();
+            stream.rFrameRate = r.getRational();
+            ok = ok && r.ok();
+            entry->streams.push_back(std::move(stream));
+        }
+    }
+    std::fclose(file);
+    if (!ok || !r.ok()) {
+        LOGW(TAG, "探测缓存已失效: %s", path);
+        return false;
+    }
+    return true;
+}
+
+bool ProbeCache::store(const char* path, const AVFormatContext* fmt) const {
+    int64_t size = 0;
+    int64_t mtime = 0;
+    if (!enabled() || !fmt->iformat || fmt->nb_streams == 0 || fmt->nb_streams > kMaxStreams ||
+        !statFile(path, &size, &mtime)) {
+        return false;
+    }
+    // 先写临时文件再改名，避免读到写了一半的缓存
+    const std::string target = entryPath(path);
+    const std::string temp = target + ".tmp";
+    FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) {
+        LOGW(TAG, "无法写入探测缓存: %s", temp.c_str());
+        return false;
+    }
+
+    Writer w(file);
+    w.put(kMagic);
+    w.put(kVersion);
+    w.putString(path);
+    w.put<int64_t>(size);
+    w.put<int64_t>(mtime);
+    w.putString(fmt->iformat->name);
+    w.put<int64_t>(fmt->duration);
+    w.put<int64_t>(fmt->bit_rate);
+    w.put<uint32_t>(fmt->nb_streams);
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        const AVStream* st = fmt->streams[i];
+        writeParameters(w, st->codecpar);
+        w.putRational(st->time_base);
+        w.putRational(st->avg_frame_rate);
+        w.putRational(st->r_frame_rate);
+    }
+    const bool ok = w.ok() && std::fclose(file) == 0;
+    if (!ok || std::rename(temp.c_str(), target.c_str()) != 0) {
+        std::remove(temp.c_str());
+        LOGW(TAG, "写入探测缓存失败: %s", target.c_str());
+        return false;
+    }
+    LOGI(TAG, "已缓存探测结果: %s (%u 路流)", path, fmt->nb_streams);
+    return true;
+}
+
+bool ProbeCache::restore(const ProbeCacheEntry& entry, AVFormatContext* fmt) {
+    if (!fmt->iformat || entry.formatName != fmt->iformat->name ||
+        fmt->nb_streams != entry.streams.size()) {
+        return false;
+    }
+    // 先全部校验，确认布局一致后再修改
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        const AVCodecParameters* cached = entry.streams[i].par.get();
+        const AVCodecParameters* actual = fmt->streams[i]->codecpar;
+        if (cached->codec_type != actual->codec_type) {
+            return false;
+        }
+        if (actual->codec_id != AV_CODEC_ID_NONE && cached->codec_id != actual->codec_id) {
+            return false;
+        }
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        const CachedStream& cached = entry.streams[i];
+        AVStream* st = fmt->streams[i];
+        if (avcodec_parameters_copy(st->codecpar, cached.par.get()) < 0) {
+            return false;
+        }
+        if (cached.avgFrameRate.num > 0 && cached.avgFrameRate.den > 0) {
+            st->avg_frame_rate = cached.avgFrameRate;
+        }
+        if (cached.rFrameRate.num > 0 && cached.rFrameRate.den > 0) {
+            st->r_frame_rate = cached.rFrameRate;
+        }
+    }
+    if (fmt->duration == AV_NOPTS_VALUE) {
+        fmt->duration = entry.duration;
+    }
+    if (fmt->bit_rate <= 0) {
+        fmt->bit_rate = entry.bitRate;
+    }
+    return true;
+}
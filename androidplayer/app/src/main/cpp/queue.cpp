@@ -1,67 +1,136 @@
-#include <queue>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
-#include <android/log.h>
-#include "libavcodec/packet.h"
-#include "libavutil/frame.h"
+#include "queue.h"
+#include "log.h"
+extern "C" {
+#include "libavutil/mathematics.h"
+}
 
 #define LOG_TAG "PacketQueue"
-#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
-#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// 把元素的 duration 换算成微秒，时间基未设置时不计时长
+static int64_t durationToUs(int64_t duration, AVRational timeBase) {
+    if (duration <= 0 || timeBase.num <= 0 || timeBase.den <= 0) {
+        return 0;
+    }
+    return av_rescale_q(duration, timeBase, AV_TIME_BASE_Q);
+}
+
+template <typename T>
+PacketQueue<T>::PacketQueue(const QueueLimits& limits) : limits_(limits) {}
 
 template <typename T>
-class PacketQueue {
-public:
-    void push(T item) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(item);
-        ++size_; // 入队时增加队列大小
-        LOGI("队列大小增加: %zu", size_);
-        cond_.notify_one();
+bool PacketQueue<T>::push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (isFullLocked() && !finished_) {
+        ++stats_.blockedPushes;
+        // 队列已满，等待消费者取走数据
+        condNotFull_.wait(lock, [this]{ return !isFullLocked() || finished_; });
+    }
+    if (finished_) {
+        LOGE(LOG_TAG, "队列已标记为 finished，丢弃入队请求");
+        return false;
     }
 
-    T pop() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cond_.wait(lock, [this]{ return !queue_.empty() || finished_; });
+    queue_.push(item);
+    ++size_; // 入队时增加队列大小
+    stats_.packets = size_;
+    stats_.bytes += queueItemBytes(item);
+    stats_.durationUs += durationToUs(queueItemDuration(item), timeBase_);
+    ++stats_.totalPushed;
+    LOGV(LOG_TAG, "队列大小增加: %zu", size_);
+    cond_.notify_one();
+    return true;
+}
 
-        if (queue_.empty() && finished_) {
-            LOGI("队列为空且已标记为 finished");
-            return nullptr;
-        }
+template <typename T>
+T PacketQueue<T>::pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]{ return !queue_.empty() || finished_; });
 
-        T item = queue_.front();
-        queue_.pop();
-        --size_; // 出队时减少队列大小
-        LOGI("队列大小减少: %zu", size_);
-        return item;
+    if (queue_.empty() && finished_) {
+        LOGI(LOG_TAG, "队列为空且已标记为 finished");
+        return nullptr;
     }
 
-    void setFinished(bool finished) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        finished_ = finished;
-        LOGI("队列标记为 finished: %d", finished_);
-        cond_.notify_all();
+    T item = queue_.front();
+    queue_.pop();
+    --size_; // 出队时减少队列大小
+    stats_.packets = size_;
+    stats_.bytes -= queueItemBytes(item);
+    stats_.durationUs -= durationToUs(queueItemDuration(item), timeBase_);
+    if (size_ == 0) {
+        // 队列清空时归零，避免 duration 换算的舍入误差累积
+        stats_.bytes = 0;
+        stats_.durationUs = 0;
     }
+    LOGV(LOG_TAG, "队列大小减少: %zu", size_);
+    condNotFull_.notify_one();
+    return item;
+}
 
-    bool isFinished() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return finished_ && queue_.empty();
-    }
+template <typename T>
+void PacketQueue<T>::setFinished(bool finished) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = finished;
+    LOGI(LOG_TAG, "队列标记为 finished: %d", finished_);
+    cond_.notify_all();
+    condNotFull_.notify_all();
+}
 
-    size_t size() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return size_; // 返回队列大小
-    }
+template <typename T>
+bool PacketQueue<T>::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_ && queue_.empty();
+}
 
-private:
-    std::queue<T> queue_;
-    mutable std::mutex mutex_;
-    std::condition_variable cond_;
-    bool finished_ = false;
-    size_t size_ = 0; // 记录队列大小
-};
+template <typename T>
+size_t PacketQueue<T>::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_; // 返回队列大小
+}
+
+template <typename T>
+void PacketQueue<T>::setTimeBase(AVRational timeBase) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeBase_ = timeBase;
+}
+
+template <typename T>
+void PacketQueue<T>::setLimits(const QueueLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+    // 上限可能被放宽，唤醒阻塞的生产者重新检查
+    condNotFull_.notify_all();
+}
+
+template <typename T>
+bool PacketQueue<T>::isFull() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isFullLocked();
+}
+
+template <typename T>
+QueueStats PacketQueue<T>::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+template <typename T>
+bool PacketQueue<T>::isFullLocked() const {
+    if (queue_.empty()) {
+        return false;
+    }
+    if (limits_.maxPackets > 0 && size_ >= limits_.maxPackets) {
+        return true;
+    }
+    if (limits_.maxBytes > 0 && stats_.bytes >= limits_.maxBytes) {
+        return true;
+    }
+    if (limits_.maxDurationUs > 0 && stats_.durationUs >= limits_.maxDurationUs) {
+        return true;
+    }
+    return false;
+}
 
 // 显式实例化模板类，支持 AVPacket 和 AVFrame
 template class PacketQueue<AVPacket*>;
-template class PacketQueue<AVFrame*>;
\ No newline at end of file
+template class PacketQueue<AVFrame*>;
@@ -0,0 +1,267 @@
+#include "readaheadfileio.h"
+#include "log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/error.h>
+}
+
+#define TAG "ReadAheadFileIO"
+
+ReadAheadFileIO::~ReadAheadFileIO() {
+    close();
+}
+
+bool ReadAheadFileIO::open(const char* path) {
+    close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        LOGE(TAG, "打开文件失败: %s (%s)", path, std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && S_ISREG(st.st_mode)) {
+        size_ = st.st_size;
+        // 告诉内核按顺序读，加大内核自身的预读
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(kAvioBufferSize));
+    if (!buffer) {
+        LOGE(TAG, "分配 AVIO 缓冲区失败");
+        close();
+        return false;
+    }
+    avio_ = avio_alloc_context(buffer, kAvioBufferSize, 0, this, readPacket, nullptr, seek);
+    if (!avio_) {
+        LOGE(TAG, "创建 AVIOContext 失败");
+        av_free(buffer);
+        close();
+        return false;
+    }
+    // 大小未知的文件（管道等）不支持 seek
+    if (size_ < 0) {
+        avio_->seekable = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_.assign(kDefaultWindow, 0);
+        resetWindowLocked(0);
+        stopping_ = false;
+        stats_ = FileIOStats();
+    }
+    reader_ = std::thread(&ReadAheadFileIO::readerLoop, this);
+
+    LOGI(TAG, "打开本地文件 %s, 大小 %lld 字节, 预读窗口 %zu 字节", path, (long long)size_, windowSize());
+    return true;
+}
+
+void ReadAheadFileIO::close() {
+    if (reader_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        spaceReady_.notify_all();
+        dataReady_.notify_all();
+        reader_.join();
+    }
+    if (avio_) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = -1;
+    std::vector<uint8_t>().swap(window_);
+}
+
+FileIOStats ReadAheadFileIO::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t ReadAheadFileIO::windowSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return window_.size();
+}
+
+void ReadAheadFileIO::setBitrate(int64_t bitsPerSecond) {
+    // 管道等不能重读的输入不调整窗口，缩小窗口会丢掉已经读出的数据
+    if (bitsPerSecond <= 0 || size_ < 0) {
+        return;
+    }
+    size_t size = static_cast<size_t>(bitsPerSecond / 8 * kReadAheadSeconds);
+    size = std::min(std::max(size, kMinWindow), kMaxWindow);
+    // 按块对齐，读线程每次都能读满一块
+    size = (size + kBlockSize - 1) / kBlockSize * kBlockSize;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size == window_.size()) {
+            return;
+        }
+        resizeWindowLocked(size);
+    }
+    spaceReady_.notify_one();
+    LOGI(TAG, "码率 %lld bit/s, 预读窗口调整为 %zu 字节", (long long)bitsPerSecond, size);
+}
+
+void ReadAheadFileIO::resizeWindowLocked(size_t size) {
+    std::vector<uint8_t> window(size);
+    const size_t keep = std::min(windowBytes_, size);
+    for (size_t i = 0; i < keep; i++) {
+        const int64_t offset = windowStart_ + static_cast<int64_t>(i);
+        window[offset % size] = window_[offset % window_.size()];
+    }
+    window_.swap(window);
+    if (keep < windowBytes_) {
+        // 丢掉了窗口尾部，读线程要从新的窗口末尾继续读
+        windowBytes_ = keep;
+        eof_ = false;
+        generation_++;
+    }
+}
+
+void ReadAheadFileIO::resetWindowLocked(int64_t offset) {
+    windowStart_ = offset;
+    windowBytes_ = 0;
+    eof_ = false;
+    error_ = 0;
+    generation_++;
+}
+
+void ReadAheadFileIO::readerLoop() {
+    std::vector<uint8_t> block(kBlockSize);
+    uint64_t hintedGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        spaceReady_.wait(lock, [this] {
+            return stopping_ || (!eof_ && error_ == 0 && windowBytes_ < window_.size());
+        });
+        if (stopping_) {
+            break;
+        }
+        const int64_t offset = windowStart_ + static_cast<int64_t>(windowBytes_);
+        const size_t want = std::min(kBlockSize, window_.size() - windowBytes_);
+        const uint64_t generation = generation_;
+        const size_t windowSize = window_.size();
+        lock.unlock();
+
+        // 新窗口（打开或 seek 之后）提示内核提前把整个窗口读进页缓存
+        if (generation != hintedGeneration && size_ > 0) {
+            posix_fadvise(fd_, offset, static_cast<off_t>(windowSize), POSIX_FADV_WILLNEED);
+            hintedGeneration = generation;
+        }
+        ssize_t n = size_ >= 0 ? pread(fd_, block.data(), want, offset) : ::read(fd_, block.data(), want);
+        const int readErrno = errno;
+
+        lock.lock();
+        stats_.syscallReads++;
+        if (generation != generation_) {
+            // 读的过程中窗口被丢弃或缩小，这次的数据已经过期
+            continue;
+        }
+        if (n < 0) {
+            if (readErrno == EINTR) {
+                continue;
+            }
+            error_ = AVERROR(readErrno);
+            LOGE(TAG, "读取文件失败: %s", std::strerror(readErrno));
+        } else if (n == 0) {
+            eof_ = true;
+        } else {
+            // 窗口可能在读的过程中被缩小，只放得下的部分
+            size_t count = std::min(static_cast<size_t>(n), window_.size() - windowBytes_);
+            for (size_t done = 0; done < count;) {
+                const size_t index = static_cast<size_t>((offset + done) % window_.size());
+                const size_t chunk = std::min(count - done, window_.size() - index);
+                std::memcpy(window_.data() + index, block.data() + done, chunk);
+                done += chunk;
+            }
+            windowBytes_ += count;
+        }
+        dataReady_.notify_one();
+    }
+}
+
+int ReadAheadFileIO::readPacket(void* opaque, uint8_t* buf, int bufSize) {
+    ReadAheadFileIO* self = static_cast<ReadAheadFileIO*>(opaque);
+    std::unique_lock<std::mutex> lock(self->mutex_);
+    if (self->windowBytes_ == 0 && !self->eof_ && self->error_ == 0) {
+        // 读线程没跟上，只能等存储
+        self->stats_.stalls++;
+        self->dataReady_.wait(lock, [self] {
+            return self->windowBytes_ > 0 || self->eof_ || self->error_ != 0 || self->stopping_;
+        });
+    }
+    if (self->windowBytes_ == 0) {
+        return self->error_ != 0 ? self->error_ : AVERROR_EOF;
+    }
+
+    const size_t count = std::min(static_cast<size_t>(bufSize), self->windowBytes_);
+    for (size_t done = 0; done < count;) {
+        const size_t index = static_cast<size_t>((self->windowStart_ + done) % self->window_.size());
+        const size_t chunk = std::min(count - done, self->window_.size() - index);
+        std::memcpy(buf + done, self->window_.data() + index, chunk);
+        done += chunk;
+    }
+    self->windowStart_ += count;
+    self->windowBytes_ -= count;
+    self->stats_.readCalls++;
+    self->stats_.bytesRead += count;
+    lock.unlock();
+    self->spaceReady_.notify_one();
+    return static_cast<int>(count);
+}
+
+int64_t ReadAheadFileIO::seek(void* opaque, int64_t offset, int whence) {
+    ReadAheadFileIO* self = static_cast<ReadAheadFileIO*>(opaque);
+    if (whence == AVSEEK_SIZE) {
+        return self->size_ >= 0 ? self->size_ : AVERROR(ENOSYS);
+    }
+    whence &= ~AVSEEK_FORCE;
+
+    std::unique_lock<std::mutex> lock(self->mutex_);
+    int64_t target;
+    switch (whence) {
+        case SEEK_SET:
+            target = offset;
+            break;
+        case SEEK_CUR:
+            target = self->windowStart_ + offset;
+            break;
+        case SEEK_END:
+            if (self->size_ < 0) {
+                return AVERROR(ENOSYS);
+            }
+            target = self->size_ + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+    if (target < 0 || (self->size_ < 0 && target != self->windowStart_)) {
+        return AVERROR(EINVAL);
+    }
+    self->stats_.seeks++;
+
+    const int64_t windowEnd = self->windowStart_ + static_cast<int64_t>(self->windowBytes_);
+    if (target >= self->windowStart_ && target <= windowEnd) {
+        // 落在已预读的范围内，跳过前面的数据即可
+        self->windowBytes_ -= static_cast<size_t>(target - self->windowStart_);
+        self->windowStart_ = target;
+    } else {
+        self->resetWindowLocked(target);
+        self->stats_.windowResets++;
+    }
+    lock.unlock();
+    self->spaceReady_.notify_one();
+    return target;
+}
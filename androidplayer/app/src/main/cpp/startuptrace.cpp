@@ -0,0 +1,67 @@
+#include "startuptrace.h"
+#include "log.h"
+#include <chrono>
+#include <cstdio>
+
+#define TAG "StartupTrace"
+
+StartupTrace::StartupTrace() {
+    begin();
+}
+
+int64_t StartupTrace::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StartupTrace::begin() {
+    for (auto& phase : phaseUs_) {
+        phase.store(-1, std::memory_order_relaxed);
+    }
+    beginUs_.store(nowUs(), std::memory_order_release);
+}
+
+void StartupTrace::mark(StartupPhase phase) {
+    const int64_t elapsed = nowUs() - beginUs_.load(std::memory_order_acquire);
+    int64_t expected = -1;
+    phaseUs_[static_cast<int>(phase)].compare_exchange_strong(expected, elapsed, std::memory_order_relaxed);
+}
+
+int64_t StartupTrace::elapsedUs(StartupPhase phase) const {
+    return phaseUs_[static_cast<int>(phase)].load(std::memory_order_relaxed);
+}
+
+const char* StartupTrace::phaseName(StartupPhase phase) {
+    switch (phase) {
+        case StartupPhase::Open:
+            return "打开文件";
+        case StartupPhase::Probe:
+            return "探测流信息";
+        case StartupPhase::VideoCodecOpen:
+            return "视频解码器";
+        case StartupPhase::AudioCodecOpen:
+            return "音频解码器";
+        case StartupPhase::CodecOpen:
+            return "解码器就绪";
+        case StartupPhase::FirstPacket:
+            return "首个包";
+        case StartupPhase::FirstFrame:
+            return "首帧显示";
+        default:
+            return "未知";
+    }
+}
+
+void StartupTrace::report() const {
+    char line[256];
+    int len = 0;
+    for (int i = 0; i < static_cast<int>(StartupPhase::Count) && len < (int)sizeof(line); i++) {
+        const int64_t us = phaseUs_[i].load(std::memory_order_relaxed);
+        if (us < 0) {
+            continue;
+        }
+        len += std::snprintf(line + len, sizeof(line) - len, "%s%s %.1fms", len ? ", " : "",
+                             phaseName(static_cast<StartupPhase>(i)), us / 1000.0);
+    }
+    LOGI(TAG, "启动耗时: %s", len ? line : "无记录");
+}
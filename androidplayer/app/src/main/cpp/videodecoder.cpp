@@ -1,136 +1,502 @@
 #include "videodecoder.h"
-#include "opengl_renderer.h"
 
-#include <android/log.h>
+#include "log.h"
 #include <unistd.h>
+#include <algorithm>
 extern "C" {
 #include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
 }
 #define TAG "Decoder"
 
-VideoDecoder::VideoDecoder(VideoProcessingContext& ctx) : ctx_(ctx) {}
+// 解码器输出缓冲区的对齐，覆盖各平台 SIMD 要求的最大行对齐（x86 AVX-512 为 64）
+static constexpr int kDecoderBufferAlign = 64;
+
+// 默认只把 YUV420P 交给渲染器，其他格式都需要转换
+static const AVPixelFormat kDefaultOutputFormats[] = {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE};
+
+VideoDecoder::VideoDecoder(VideoProcessingContext& ctx)
+        : ctx_(ctx), outputFormats_(kDefaultOutputFormats), decoderPool_(kDecoderBufferAlign) {}
+
+VideoDecoder::~VideoDecoder() {
+    sws_freeContext(sws_ctx_);
+    // 解码器上下文比 VideoDecoder 活得久，不能再回调到这里
+    if (ctx_.codec_ctx && ctx_.codec_ctx->opaque == this) {
+        ctx_.codec_ctx->get_buffer2 = avcodec_default_get_buffer2;
+        ctx_.codec_ctx->opaque = nullptr;
+    }
+}
+
+void VideoDecoder::setClock(MasterClock* clock) {
+    clock_ = clock;
+}
+
+void VideoDecoder::setTargetSize(int width, int height) {
+    targetWidth_ = width > 0 ? width : 0;
+    targetHeight_ = height > 0 ? height : 0;
+}
+
+void VideoDecoder::setOutputFormats(const AVPixelFormat* formats) {
+    outputFormats_ = formats ? formats : kDefaultOutputFormats;
+}
+
+bool VideoDecoder::isOutputFormat(int format) const {
+    for (const AVPixelFormat* fmt = outputFormats_; *fmt != AV_PIX_FMT_NONE; fmt++) {
+        if (*fmt == format) {
+            return true;
+        }
+    }
+    return false;
+}
 
 bool VideoDecoder::setupDecoder() {
     ctx_.codec = avcodec_find_decoder(ctx_.codec_par->codec_id);
     if (!ctx_.codec) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "找不到解码器");
+        LOGE(TAG, "找不到解码器");
         return false;
     }
 
     ctx_.codec_ctx = avcodec_alloc_context3(ctx_.codec);
+    if (!ctx_.codec_ctx) {
+        LOGE(TAG, "无法分配解码器上下文");
+        return false;
+    }
     if (avcodec_parameters_to_context(ctx_.codec_ctx, ctx_.codec_par) < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "无法复制编解码参数");
+        LOGE(TAG, "无法复制编解码参数");
         return false;
     }
 
+    // 多线程设置必须在 avcodec_open2 之前
+    threading_ = chooseDecoderThreading(ctx_.codec, ctx_.codec_par->width, ctx_.codec_par->height);
+    applyDecoderThreading(ctx_.codec_ctx, threading_);
+    chooseLowres();
+    // 解码器直接写入可以移交给渲染器的缓冲区，渲染器释放帧后缓冲区按引用计数回到池中
+    if (ctx_.codec->capabilities & AV_CODEC_CAP_DR1) {
+        ctx_.codec_ctx->opaque = this;
+        ctx_.codec_ctx->get_buffer2 = getBuffer;
+#if FF_API_THREAD_SAFE_CALLBACKS
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+        // getBuffer 只访问加锁的帧缓冲池，帧级多线程的工作线程可以直接调用，不必转回解码线程
+        ctx_.codec_ctx->thread_safe_callbacks = 1;
+#pragma GCC diagnostic pop
+#endif
+    }
+
     if (avcodec_open2(ctx_.codec_ctx, ctx_.codec, nullptr) < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "无法打开解码器");
+        LOGE(TAG, "无法打开解码器");
         return false;
     }
+    LOGI(TAG, "解码线程策略: %s, 线程数 %d (在线核数 %d)",
+         decoderThreadTypeName(ctx_.codec_ctx->active_thread_type),
+         ctx_.codec_ctx->thread_count, threading_.onlineCores);
 
-    // 初始化图像转换器
-    sws_ctx_ = sws_getContext(
-            ctx_.codec_ctx->width, ctx_.codec_ctx->height, ctx_.codec_ctx->pix_fmt,
-            ctx_.codec_ctx->width, ctx_.codec_ctx->height, AV_PIX_FMT_YUV420P,
-            SWS_BILINEAR, nullptr, nullptr, nullptr
-    );
-
-    __android_log_print(ANDROID_LOG_INFO, TAG, "解码器初始化完成 %dx%d",
-                        ctx_.codec_ctx->width, ctx_.codec_ctx->height);
+    // 图像转换器在第一次遇到渲染器不支持的格式或需要缩小的帧时才创建
+    int outWidth = 0;
+    int outHeight = 0;
+    outputSize(ctx_.codec_ctx->width, ctx_.codec_ctx->height, &outWidth, &outHeight);
+    const bool scaled = outWidth != ctx_.codec_ctx->width || outHeight != ctx_.codec_ctx->height;
+    LOGI(TAG, "解码器初始化完成 %dx%d %s, %s, 输出 %dx%d",
+         ctx_.codec_ctx->width, ctx_.codec_ctx->height,
+         av_get_pix_fmt_name(ctx_.codec_ctx->pix_fmt),
+         isOutputFormat(ctx_.codec_ctx->pix_fmt) && !scaled ? "直通渲染" : "需要转换为 YUV420P",
+         outWidth, outHeight);
+    if (ctx_.startup_trace) {
+        ctx_.startup_trace->mark(StartupPhase::VideoCodecOpen);
+    }
     return true;
 }
 
-void VideoDecoder::decode(PacketQueue<AVPacket*>& packetQueue, PacketQueue<AVFrame*>& frameQueue, ANativeWindow* window) {
-    AVFrame* frame = av_frame_alloc();
-    SwsContext* sws_ctx = nullptr;
+int VideoDecoder::getBuffer(AVCodecContext* codecCtx, AVFrame* frame, int flags) {
+    VideoDecoder* self = static_cast<VideoDecoder*>(codecCtx->opaque);
+    if (!self || codecCtx->hw_frames_ctx || !self->isOutputFormat(frame->format)) {
+        return avcodec_default_get_buffer2(codecCtx, frame, flags);
+    }
+    // 解码器按宏块写入，分配尺寸要对齐到它要求的宽高，每行的对齐不能超过池的对齐。
+    // FramePool::fill 把每个平面的起始地址和 linesize 都对齐到 align()，这里比较的是实际提供的对齐
+    int width = frame->width;
+    int height = frame->height;
+    int linesizeAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(codecCtx, &width, &height, linesizeAlign);
+    for (int i = 0; i < 4; i++) {
+        if (linesizeAlign[i] > self->decoderPool_.align()) {
+            return avcodec_default_get_buffer2(codecCtx, frame, flags);
+        }
+    }
+    if (!self->decoderPool_.fill(frame, (AVPixelFormat)frame->format, width, height)) {
+        return avcodec_default_get_buffer2(codecCtx, frame, flags);
+    }
+    self->pooledBuffers_.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
 
+// 渲染器按 linesize 上传纹理，行填充不影响直通；只有倒序存放（负 linesize）的帧仍需经过转换
+bool VideoDecoder::isUploadable(const AVFrame* frame) {
+    const int chromaWidth = (frame->width + 1) / 2;
+    return frame->linesize[0] >= frame->width &&
+           frame->linesize[1] >= chromaWidth &&
+           frame->linesize[2] >= chromaWidth;
+}
+
+// 渲染器把画面铺满整个 Surface，两个方向分别不超过 Surface 的像素数即可，多出的分辨率显示不出来
+void VideoDecoder::outputSize(int width, int height, int* outWidth, int* outHeight) const {
+    *outWidth = width;
+    *outHeight = height;
+    // YUV420P 的色度平面按 2 对齐
+    if (targetWidth_ > 0 && width > targetWidth_) {
+        *outWidth = std::max(2, targetWidth_ & ~1);
+    }
+    if (targetHeight_ > 0 && height > targetHeight_) {
+        *outHeight = std::max(2, targetHeight_ & ~1);
+    }
+}
+
+// MJPEG 等支持 lowres 的解码器直接按 1/2、1/4、1/8 分辨率解码，省掉大部分解码和缩放的开销。
+// 只选不会低于 Surface 尺寸的等级，剩下的差距由 sws_scale 补齐
+void VideoDecoder::chooseLowres() {
+    const int width = ctx_.codec_ctx->width;
+    const int height = ctx_.codec_ctx->height;
+    if (targetWidth_ <= 0 || targetHeight_ <= 0 || width <= 0 || height <= 0) {
+        return;
+    }
+    int outWidth = 0;
+    int outHeight = 0;
+    outputSize(width, height, &outWidth, &outHeight);
+    int lowres = 0;
+    while (lowres < ctx_.codec->max_lowres &&
+           AV_CEIL_RSHIFT(width, lowres + 1) >= outWidth &&
+           AV_CEIL_RSHIFT(height, lowres + 1) >= outHeight) {
+        lowres++;
+    }
+    if (lowres == 0) {
+        return;
+    }
+    ctx_.codec_ctx->lowres = lowres;
+    LOGI(TAG, "Surface %dx%d, 使用 lowres=%d 解码 %dx%d -> %dx%d", targetWidth_, targetHeight_, lowres,
+         width, height, AV_CEIL_RSHIFT(width, lowres), AV_CEIL_RSHIFT(height, lowres));
+}
+
+// 把解码出的帧转换为 YUV420P，用于渲染器不支持的格式，以及需要缩小到 Surface 尺寸的帧。
+// 缩小和格式转换在同一次 sws_scale 中完成，不产生全尺寸的中间帧
+AVFrame* VideoDecoder::convertFrame(AVFrame* frame) {
+    int outWidth = 0;
+    int outHeight = 0;
+    outputSize(frame->width, frame->height, &outWidth, &outHeight);
+    // 格式或尺寸变化时才重建 SWS 上下文
+    if (!sws_ctx_ || frame->format != swsSrcFormat_ ||
+        frame->width != swsWidth_ || frame->height != swsHeight_ ||
+        outWidth != swsOutWidth_ || outHeight != swsOutHeight_) {
+        sws_freeContext(sws_ctx_);
+        sws_ctx_ = sws_getContext(
+                frame->width, frame->height, (AVPixelFormat)frame->format,
+                outWidth, outHeight, AV_PIX_FMT_YUV420P,
+                SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws_ctx_) {
+            LOGE(TAG, "初始化SWS上下文失败");
+            return nullptr;
+        }
+        swsSrcFormat_ = frame->format;
+        swsWidth_ = frame->width;
+        swsHeight_ = frame->height;
+        swsOutWidth_ = outWidth;
+        swsOutHeight_ = outHeight;
+    }
+
+    // 从帧缓冲池取出已分配好的 32 字节对齐的帧，渲染器释放后缓冲区自动回到池中
+    AVFrame* yuv420p_frame = framePool_.acquire(AV_PIX_FMT_YUV420P, outWidth, outHeight);
+    if (!yuv420p_frame) {
+        LOGE(TAG, "分配YUV帧失败");
+        return nullptr;
+    }
+
+    // 执行转换
+    sws_scale(sws_ctx_,
+              frame->data, frame->linesize, 0, frame->height,
+              yuv420p_frame->data, yuv420p_frame->linesize);
+    av_frame_copy_props(yuv420p_frame, frame);
+    return yuv420p_frame;
+}
+
+void VideoDecoder::decode(SpscQueue<AVPacket*>& packetQueue, CircularBuffer& frameQueue) {
+    AVFrame* frame = av_frame_alloc();
+    // 当前数据所属的序号，收到 seek 标记包时更新
+    uint32_t serial = ctx_.control ? ctx_.control->serial() : 0;
 
     while (!ctx_.decoding_completed) {
-        AVPacket* pkt = packetQueue.pop();
-        if (!pkt && ctx_.demuxing_completed) {
-            __android_log_print(ANDROID_LOG_INFO, TAG, "解码完成");
-            break;
+        // 用完后自动归还到回收池
+        PooledPacket pkt(ctx_.packet_pool, packetQueue.pop());
+        // 队列已结束且取空，或者收到解复用线程的结束标记：把空包送进解码器，
+        // 帧线程和 B 帧重排压住的最后几帧照常输出。队列结束时随后退出，结束标记只排空不退出
+        const bool queueEnded = !pkt;
+        const bool endOfStream = queueEnded || isEndOfStreamMarker(pkt.get());
+        if (isSeekMarker(pkt.get())) {
+            // seek 之后的数据从这里开始，清空解码器里参考帧和尚未输出的帧
+            serial = seekMarkerSerial(pkt.get());
+            avcodec_flush_buffers(ctx_.codec_ctx);
+            beginSeek(serial);
+            continue;
+        }
+        if (!queueEnded && ctx_.control && ctx_.control->isStale(serial)) {
+            // 已经有新的 seek 请求，标记包之前的包都不用再解码
+            continue;
+        }
+        if (seekTarget_ != AV_NOPTS_VALUE) {
+            // 目标之前的非参考帧没有其他帧依赖，也不会显示，解码器可以整帧跳过。
+            // 参考帧的环路滤波不能跳过，否则误差会一直带到目标帧；排空时沿用当前设置
+            if (!endOfStream) {
+                ctx_.codec_ctx->skip_frame = beforeSeekTarget(pkt->pts, pkt->duration) ? AVDISCARD_NONREF
+                                                                                       : AVDISCARD_DEFAULT;
+                ctx_.codec_ctx->skip_loop_filter = AVDISCARD_DEFAULT;
+            }
+        } else if (!previewPending_ && !endOfStream) {
+            applyDropTier(pkt.get());
         }
 
         // 发送数据包到解码器
-        int send_ret = avcodec_send_packet(ctx_.codec_ctx, pkt);
-        av_packet_free(&pkt);
+        auto decodeBegin = std::chrono::steady_clock::now();
+        int send_ret = avcodec_send_packet(ctx_.codec_ctx, endOfStream ? nullptr : pkt.get());
+        pkt.reset();
+        // 预览只有这一个关键帧，解码器有帧延迟（多线程、B 帧重排）时要排空才能拿到画面
+        const bool preview = previewPending_ && !endOfStream;
+        if (preview && send_ret >= 0) {
+            avcodec_send_packet(ctx_.codec_ctx, nullptr);
+        }
+        addDecodeTime(decodeBegin);
 
         if (send_ret < 0 && send_ret != AVERROR(EAGAIN)) {
-            __android_log_print(ANDROID_LOG_ERROR, TAG, "发送Packet失败: %d", send_ret);
-            continue;
+            LOGE(TAG, "发送Packet失败: %d", send_ret);
+            if (!endOfStream) {
+                continue;
+            }
+            // 排空失败也要照常退出或写入结束帧
         }
 
         // 接收解码后的帧
         while (true) {
+            decodeBegin = std::chrono::steady_clock::now();
             int recv_ret = avcodec_receive_frame(ctx_.codec_ctx, frame);
+            addDecodeTime(decodeBegin);
             if (recv_ret == AVERROR(EAGAIN) || recv_ret == AVERROR_EOF) break;
             else if (recv_ret < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "接收Frame失败: %d", recv_ret);
+                LOGE(TAG, "接收Frame失败: %d", recv_ret);
                 break;
             }
-
-            // 确保目标格式是YUV420P
-            AVFrame* yuv420p_frame = av_frame_alloc();
-            yuv420p_frame->format = AV_PIX_FMT_YUV420P;
-            yuv420p_frame->width = frame->width;
-            yuv420p_frame->height = frame->height;
-
-            // 关键修改：显式分配缓冲区并手动填充数据
-            if (av_frame_get_buffer(yuv420p_frame, 32) < 0) { // 32字节对齐
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "分配YUV帧失败");
-                av_frame_free(&yuv420p_frame);
+            decodedFrames_.fetch_add(1, std::memory_order_relaxed);
+            reportDecodeStats(false);
+            if (ctx_.control && ctx_.control->isStale(serial)) {
                 av_frame_unref(frame);
                 continue;
             }
-
-            // 初始化SWS上下文（仅当格式不同时）
-            if (!sws_ctx || frame->format != ctx_.codec_ctx->pix_fmt) {
-                sws_freeContext(sws_ctx);
-                sws_ctx = sws_getContext(
-                        frame->width, frame->height, (AVPixelFormat)frame->format,
-                        yuv420p_frame->width, yuv420p_frame->height, AV_PIX_FMT_YUV420P,
-                        SWS_BILINEAR, nullptr, nullptr, nullptr);
-                if (!sws_ctx) {
-                    __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化SWS上下文失败");
-                    av_frame_free(&yuv420p_frame);
+            if (seekTarget_ != AV_NOPTS_VALUE) {
+                if (beforeSeekTarget(frame->best_effort_timestamp, frame->pkt_duration)) {
+                    // 只解码不输出：不做格式转换，不进帧队列，也不会被渲染
+                    seekSkipped_++;
+                    seekSkippedFrames_.fetch_add(1, std::memory_order_relaxed);
                     av_frame_unref(frame);
                     continue;
                 }
+                finishSeek();
+            }
+            if (dropForLateness(frame, serial)) {
+                // 已经来不及显示，省掉格式转换和入队
+                av_frame_unref(frame);
+                continue;
             }
 
-            // 执行转换
-            sws_scale(sws_ctx,
-                      frame->data, frame->linesize, 0, frame->height,
-                      yuv420p_frame->data, yuv420p_frame->linesize);
-
-            // 验证数据（调试用）
-            __android_log_print(ANDROID_LOG_DEBUG, TAG,
-                                "YUV数据: Y[0]=%d, U[0]=%d, V[0]=%d",
-                                yuv420p_frame->data[0][0],
-                                yuv420p_frame->data[1][0],
-                                yuv420p_frame->data[2][0]);
-
-            // 创建帧的副本放入队列
-            AVFrame* frame_copy = av_frame_alloc();
-            if (av_frame_ref(frame_copy, yuv420p_frame) < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, TAG, "创建帧副本失败");
-                av_frame_free(&frame_copy);
-            } else {
-                frameQueue.push(frame_copy);  // 将帧放入队列
+            AVFrame* converted = nullptr;
+            int outWidth = 0;
+            int outHeight = 0;
+            outputSize(frame->width, frame->height, &outWidth, &outHeight);
+            const bool scaled = outWidth != frame->width || outHeight != frame->height;
+            if (scaled || !isOutputFormat(frame->format) || !isUploadable(frame)) {
+                converted = convertFrame(frame);
+                av_frame_unref(frame);
+                if (!converted) {
+                    continue;
+                }
             }
+            // 渲染器可以直接上传的格式不转换，把解码器的缓冲区引用直接移入信箱的槽位
+            AVFrame* output = converted ? converted : frame;
+            setFrameSerial(output, serial);
 
-//            // 传递帧并渲染
-//            if (!renderer.renderFrame(yuv420p_frame)) {
-//                __android_log_print(ANDROID_LOG_ERROR, TAG, "渲染帧失败");
-//            }
+            // 验证数据（调试用）
+            LOGV(TAG,
+                 "YUV数据: Y[0]=%d, U[0]=%d, V[0]=%d",
+                 output->data[0][0],
+                 output->data[1][0],
+                 output->data[2][0]);
 
-            av_frame_unref(frame);
-            av_frame_free(&yuv420p_frame); // 渲染完后释放frame
+            if (!frameQueue.write(output)) {  // 将帧放入信箱
+                av_frame_unref(output);
+            }
+            av_frame_free(&converted);
+        }
+        if (preview) {
+            // 排空后解码器处于结束状态，清空后才能接收下一次 seek 的数据
+            avcodec_flush_buffers(ctx_.codec_ctx);
+            ctx_.codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+            previewPending_ = false;
+        }
+        if (queueEnded) {
+            LOGI(TAG, "解码完成");
+            break;
+        }
+        if (endOfStream) {
+            // 排空后解码器处于结束状态，清空后才能接收 seek 之后的数据；
+            // 结束帧排在最后一帧之后，渲染线程取到它就说明这个序号的画面都已经显示完
+            avcodec_flush_buffers(ctx_.codec_ctx);
+            makeEndOfStreamFrame(frame, serial);
+            if (!frameQueue.write(frame)) {
+                av_frame_unref(frame);
+            }
+            LOGI(TAG, "解码到结尾 (#%u)", serial);
         }
     }
 
     av_frame_free(&frame);
-    sws_freeContext(sws_ctx);
+    reportDecodeStats(true);
+    // 通知渲染线程不会再有新的帧
+    frameQueue.setFinished(true);
     ctx_.decoding_completed = true;
-}
\ No newline at end of file
+}
+
+VideoDecodeStats VideoDecoder::decodeStats() const {
+    VideoDecodeStats stats;
+    stats.frames = decodedFrames_.load(std::memory_order_relaxed);
+    stats.decodeTimeUs = decodeTimeUs_.load(std::memory_order_relaxed);
+    stats.seekSkippedFrames = seekSkippedFrames_.load(std::memory_order_relaxed);
+    stats.lateDroppedFrames = lateDroppedFrames_.load(std::memory_order_relaxed);
+    stats.pooledBuffers = pooledBuffers_.load(std::memory_order_relaxed);
+    stats.dropTier = dropTier_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void VideoDecoder::beginSeek(uint32_t serial) {
+    ctx_.codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+    // 清空后从关键帧重新开始，不会再引用之前跳过的帧
+    keyframeOnlyHeld_ = false;
+    seekTarget_ = AV_NOPTS_VALUE;
+    previewPending_ = false;
+    // 渲染线程显示新序号的第一帧之前，时钟还停留在旧的时间线上
+    dropController_.resetObservation();
+    SeekRequest request;
+    if (!ctx_.control || !ctx_.control->seekFor(serial, &request) || request.mode == SeekMode::Keyframe) {
+        LOGD(TAG, "seek #%u: 清空解码器", serial);
+        return;
+    }
+    if (request.mode == SeekMode::Preview) {
+        // 解复用线程只会送来一个关键帧
+        ctx_.codec_ctx->skip_frame = AVDISCARD_NONKEY;
+        previewPending_ = true;
+        LOGD(TAG, "seek #%u: 预览 %.3fs 附近的关键帧", serial, request.targetUs / 1000000.0);
+        return;
+    }
+    const AVRational timeBase = ctx_.format_ctx->streams[ctx_.video_stream_idx]->time_base;
+    seekTarget_ = av_rescale_q(request.targetUs, AV_TIME_BASE_Q, timeBase);
+    seekSkipped_ = 0;
+    seekBegin_ = std::chrono::steady_clock::now();
+    LOGD(TAG, "seek #%u: 清空解码器, 精确定位到 %.3fs", serial, request.targetUs / 1000000.0);
+}
+
+// 帧的显示区间 [pts, pts + duration) 整个落在目标之前；时间戳未知时按已到达处理
+bool VideoDecoder::beforeSeekTarget(int64_t pts, int64_t duration) const {
+    if (pts == AV_NOPTS_VALUE) {
+        return false;
+    }
+    return pts + (duration > 0 ? duration : 1) <= seekTarget_;
+}
+
+void VideoDecoder::finishSeek() {
+    auto elapsed = std::chrono::steady_clock::now() - seekBegin_;
+    LOGI(TAG, "精确 seek: 跳过 %llu 帧, 追赶耗时 %.1fms", (unsigned long long)seekSkipped_,
+         std::chrono::duration<double, std::milli>(elapsed).count());
+    ctx_.codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+    seekTarget_ = AV_NOPTS_VALUE;
+}
+
+bool VideoDecoder::dropForLateness(const AVFrame* frame, uint32_t serial) {
+    // 时钟还没切换到这一帧的时间线（seek 后新序号的第一帧尚未显示）时无法比较
+    if (!clock_ || clock_->serial() != serial) {
+        return false;
+    }
+    int64_t pts = frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = frame->pts;
+    }
+    const int64_t clockUs = clock_->nowUs();
+    if (pts == AV_NOPTS_VALUE || clockUs == MasterClock::kNoTime) {
+        return false;
+    }
+    const AVRational timeBase = ctx_.format_ctx->streams[ctx_.video_stream_idx]->time_base;
+    const int64_t lateUs = clockUs - av_rescale_q(pts, timeBase, AV_TIME_BASE_Q);
+
+    DropTier previous;
+    if (dropController_.update(lateUs, MasterClock::monotonicUs(), &previous)) {
+        const DropTier tier = dropController_.tier();
+        dropTier_.store(tier, std::memory_order_relaxed);
+        LOGW(TAG, "解码%s: %s -> %s (延迟 %.1fms, 已丢弃 %llu 帧)",
+             tier > previous ? "降级" : "恢复", dropTierName(previous), dropTierName(tier),
+             lateUs / 1000.0, (unsigned long long)lateDroppedFrames_.load(std::memory_order_relaxed));
+    }
+    if (!dropController_.shouldDrop(lateUs)) {
+        return false;
+    }
+    lateDroppedFrames_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void VideoDecoder::applyDropTier(const AVPacket* pkt) {
+    DropTier tier = dropController_.tier();
+    if (tier == DropTier::KeyframeOnly) {
+        keyframeOnlyHeld_ = true;
+    } else if (keyframeOnlyHeld_) {
+        // 只解关键帧期间跳过的 P 帧是后面帧的参考，GOP 中途恢复会引用缺失的帧、花屏到下一个 IDR。
+        // 要送入的是关键帧时才降到新的档位，进入这一档则可以随时生效
+        if (!(pkt->flags & AV_PKT_FLAG_KEY)) {
+            tier = DropTier::KeyframeOnly;
+        } else {
+            keyframeOnlyHeld_ = false;
+        }
+    }
+    AVDiscard skipFrame = AVDISCARD_DEFAULT;
+    AVDiscard skipLoopFilter = AVDISCARD_DEFAULT;
+    switch (tier) {
+        case DropTier::KeyframeOnly:
+            skipFrame = AVDISCARD_NONKEY;
+            skipLoopFilter = AVDISCARD_ALL;
+            break;
+        case DropTier::SkipNonRef:
+            skipFrame = AVDISCARD_NONREF;
+            skipLoopFilter = AVDISCARD_ALL;
+            break;
+        case DropTier::SkipLoopFilter:
+            skipLoopFilter = AVDISCARD_ALL;
+            break;
+        case DropTier::DropLate:
+        case DropTier::None:
+            break;
+    }
+    ctx_.codec_ctx->skip_frame = skipFrame;
+    ctx_.codec_ctx->skip_loop_filter = skipLoopFilter;
+}
+
+void VideoDecoder::addDecodeTime(std::chrono::steady_clock::time_point begin) {
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    decodeTimeUs_.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+                            std::memory_order_relaxed);
+}
+
+// 每 5 秒（以及解码结束时）输出一次平均每帧的解码耗时
+void VideoDecoder::reportDecodeStats(bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - lastStatsReport_ < std::chrono::seconds(5)) {
+        return;
+    }
+    lastStatsReport_ = now;
+    VideoDecodeStats stats = decodeStats();
+    LOGI(TAG, "已解码 %llu 帧, 平均每帧 %.2f ms (%s 线程 x%d), 降级档位 %s, 晚到丢弃 %llu 帧, 池化输出缓冲区 %llu 个",
+         (unsigned long long)stats.frames, stats.averageDecodeMs(),
+         decoderThreadTypeName(threading_.threadType), threading_.threadCount,
+         dropTierName(stats.dropTier), (unsigned long long)stats.lateDroppedFrames,
+         (unsigned long long)stats.pooledBuffers);
+}
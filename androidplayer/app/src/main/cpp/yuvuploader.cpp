@@ -0,0 +1,226 @@
+#include "yuvuploader.h"
+#include "log.h"
+#include <GLES2/gl2ext.h>
+#include <cstring>
+
+#define TAG "YuvUploader"
+
+namespace {
+
+// ES3 的 GL_UNPACK_ROW_LENGTH 与 GL_EXT_unpack_subimage 的枚举值相同
+constexpr GLenum kUnpackRowLength = GL_UNPACK_ROW_LENGTH_EXT;
+// PBO 内每个平面的起始偏移按这个值对齐
+constexpr size_t kPboPlaneAlign = 64;
+// 等待 PBO 上一次传输完成的上限，超时后这一帧改为直接上传
+constexpr GLuint64 kFenceTimeoutNs = 50000000;
+
+int glesMajorVersion() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    // "OpenGL ES 3.x ..."；Android 上请求 ES2 上下文时驱动通常也会给出 ES3 上下文
+    if (version && std::strncmp(version, "OpenGL ES ", 10) == 0 && version[10] >= '0' && version[10] <= '9') {
+        return version[10] - '0';
+    }
+    return 2;
+}
+
+bool hasExtension(const char* name) {
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    return extensions && std::strstr(extensions, name) != nullptr;
+}
+
+size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+}  // namespace
+
+YuvTextureUploader::~YuvTextureUploader() {
+    release();
+}
+
+bool YuvTextureUploader::init(YuvUploadMode mode) {
+    glGenTextures(3, textures_);
+    for (int i = 0; i < 3; i++) {
+        if (textures_[i] == 0) {
+            LOGE(TAG, "创建纹理失败");
+            release();
+            return false;
+        }
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        widths_[i] = 0;
+        heights_[i] = 0;
+    }
+    // 色度平面的宽度可能是奇数，每行不做 4 字节对齐
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const bool es3 = glesMajorVersion() >= 3;
+    rowLengthSupported_ = es3 || hasExtension("GL_EXT_unpack_subimage");
+    useRowLength_ = rowLengthSupported_;
+
+    mode_ = mode;
+    if (mode_ == YuvUploadMode::Pbo && !es3) {
+        LOGW(TAG, "上下文不是 ES3，PBO 上传退回直接上传");
+        mode_ = YuvUploadMode::Direct;
+    }
+    if (mode_ == YuvUploadMode::Pbo) {
+        GLuint buffers[kPboCount];
+        glGenBuffers(kPboCount, buffers);
+        for (int i = 0; i < kPboCount; i++) {
+            pbos_[i].buffer = buffers[i];
+        }
+        nextPbo_ = 0;
+    }
+    LOGI(TAG, "纹理上传: %s, %s", mode_ == YuvUploadMode::Pbo ? "PBO 异步" : "直接",
+         rowLengthSupported_ ? "GL_UNPACK_ROW_LENGTH" : "逐行上传（ES2）");
+    return true;
+}
+
+void YuvTextureUploader::release() {
+    if (textures_[0] != 0) {
+        glDeleteTextures(3, textures_);
+    }
+    for (int i = 0; i < 3; i++) {
+        textures_[i] = 0;
+        widths_[i] = 0;
+        heights_[i] = 0;
+    }
+    for (PboSlot& slot : pbos_) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        if (slot.buffer != 0) {
+            glDeleteBuffers(1, &slot.buffer);
+        }
+        slot = PboSlot();
+    }
+}
+
+bool YuvTextureUploader::upload(const AVFrame* frame) {
+    if (textures_[0] == 0 || !frame || !frame->data[0] || frame->width <= 0 || frame->height <= 0) {
+        return false;
+    }
+    const int chromaWidth = (frame->width + 1) / 2;
+    const int chromaHeight = (frame->height + 1) / 2;
+    const int widths[3] = {frame->width, chromaWidth, chromaWidth};
+    const int heights[3] = {frame->height, chromaHeight, chromaHeight};
+    // 纹理存储要在绑定 PBO 之前分配，否则 glTexImage2D 的空指针会被当作 PBO 内的偏移
+    for (int i = 0; i < 3; i++) {
+        ensureStorage(i, widths[i], heights[i]);
+        stats_.bytes += (uint64_t)widths[i] * heights[i];
+    }
+    stats_.frames++;
+
+    if (mode_ == YuvUploadMode::Pbo && uploadThroughPbo(frame, widths, heights)) {
+        return true;
+    }
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        uploadPlane(frame->data[i], frame->linesize[i], widths[i], heights[i]);
+    }
+    return true;
+}
+
+void YuvTextureUploader::ensureStorage(int plane, int width, int height) {
+    if (width == widths_[plane] && height == heights_[plane]) {
+        return;
+    }
+    // 只在分辨率变化时重新分配存储，之后都是 glTexSubImage2D
+    glActiveTexture(GL_TEXTURE0 + plane);
+    glBindTexture(GL_TEXTURE_2D, textures_[plane]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
+    widths_[plane] = width;
+    heights_[plane] = height;
+    stats_.allocations++;
+}
+
+// data 为客户端内存地址，或者绑定了 PBO 时的偏移
+void YuvTextureUploader::uploadPlane(const uint8_t* data, int linesize, int width, int height) {
+    if (linesize == width) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+        return;
+    }
+    if (useRowLength_) {
+        glPixelStorei(kUnpackRowLength, linesize);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(kUnpackRowLength, 0);
+        return;
+    }
+    // ES2 没有行跨度参数，逐行上传
+    for (int y = 0; y < height; y++) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, 1, GL_LUMINANCE, GL_UNSIGNED_BYTE, data + (ptrdiff_t)y * linesize);
+    }
+    stats_.rowWise++;
+}
+
+bool YuvTextureUploader::waitForSlot(PboSlot& slot) {
+    if (!slot.fence) {
+        return true;
+    }
+    GLenum result = glClientWaitSync(slot.fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        stats_.fenceWaits++;
+        result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+    }
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    return true;
+}
+
+bool YuvTextureUploader::uploadThroughPbo(const AVFrame* frame, const int* widths, const int* heights) {
+    PboSlot& slot = pbos_[nextPbo_];
+    if (!waitForSlot(slot)) {
+        // GPU 迟迟没有完成上一次传输，这一帧直接上传，不阻塞渲染线程
+        LOGW(TAG, "PBO %d 的传输超时未完成，改为直接上传", nextPbo_);
+        return false;
+    }
+
+    // 每个平面按原来的 linesize 整块拷贝，行跨度交给 GL_UNPACK_ROW_LENGTH
+    size_t offsets[3];
+    size_t size = 0;
+    for (int i = 0; i < 3; i++) {
+        offsets[i] = size;
+        size = alignUp(size + (size_t)frame->linesize[i] * (heights[i] - 1) + widths[i], kPboPlaneAlign);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    if (size > slot.size) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        slot.size = size;
+    }
+    // 已经通过 fence 确认 GPU 不再读取这块缓冲区，映射时不需要驱动再同步
+    uint8_t* mapped = static_cast<uint8_t*>(glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (!mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        LOGE(TAG, "映射 PBO 失败: 0x%x", glGetError());
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        std::memcpy(mapped + offsets[i], frame->data[i], (size_t)frame->linesize[i] * (heights[i] - 1) + widths[i]);
+    }
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        // 映射期间缓冲区内容丢失（极少见），这一帧改为直接上传
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        uploadPlane(reinterpret_cast<const uint8_t*>(offsets[i]), frame->linesize[i], widths[i], heights[i]);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    nextPbo_ = (nextPbo_ + 1) % kPboCount;
+    stats_.pboFrames++;
+    return true;
+}
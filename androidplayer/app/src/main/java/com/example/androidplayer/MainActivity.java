@@ -40,6 +40,8 @@ public class MainActivity extends AppCompatActivity {
         setContentView(binding.getRoot());
 
         SurfaceView surfaceView = binding.surfaceView;
+        // 探测结果缓存在应用缓存目录，加快下次打开
+        nativeSetCacheDir(getCacheDir().getAbsolutePath());
 
         // 请求权限
         if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.R) {
@@ -203,4 +205,5 @@ public class MainActivity extends AppCompatActivity {
         mHandler.sendMessage(msg);
     }
     public native boolean processVideo(String inputPath, String outputPath, android.view.Surface surface);
+    public native void nativeSetCacheDir(String cacheDir);
 }
\ No newline at end of file
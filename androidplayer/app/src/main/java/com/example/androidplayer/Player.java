@@ -16,6 +16,7 @@ public class Player {
     }
     private Surface mSurface;
     private PlayerState mState = PlayerState.None;
+    private PlayerState mStateBeforeScrub = PlayerState.None;
     private String fileUri;
     private double duration;
     public void setDataSource(String uri) {
@@ -44,6 +45,28 @@ public class Player {
     public void seek(double position) {
         nativeSeek(position);
     }
+    // accurate 为 true 时精确定位到 position，否则定位到最近的关键帧
+    public void seek(double position, boolean accurate) {
+        if (accurate) {
+            nativeSeekAccurate(position);
+        } else {
+            nativeSeek(position);
+        }
+    }
+    // 拖动进度条时调用，只预览关键帧；松手时调用 endScrub
+    public void scrub(double position) {
+        if (mState != PlayerState.Seeking) {
+            mStateBeforeScrub = mState;
+            mState = PlayerState.Seeking;
+        }
+        nativeScrubTo(position);
+    }
+    public void endScrub(double position) {
+        nativeScrubEnd(position);
+        if (mState == PlayerState.Seeking) {
+            mState = mStateBeforeScrub;
+        }
+    }
     public double getProgress() {
         return nativeGetPosition() / duration;
     }
@@ -56,6 +79,9 @@ public class Player {
     private native int nativePlay(String file, Surface surface);
     private native void nativePause(boolean p);
     private native int nativeSeek(double position);
+    private native int nativeSeekAccurate(double position);
+    private native int nativeScrubTo(double position);
+    private native int nativeScrubEnd(double position);
     private native int nativeStop();
     private native int nativeSetSpeed(float speed);
     private native double nativeGetPosition();